@@ -73,4 +73,28 @@ kern_return_t kcdata_get_memory_addr(kcdata_descriptor_t data, uint32_t type, ui
 kern_return_t kcdata_get_memory_addr_for_array(
 	kcdata_descriptor_t data, uint32_t type_of_element, uint32_t size_of_element, uint32_t count, mach_vm_address_t * user_addr);
 
+/*
+ * Streaming compression, see the "Compression" section of kcdata.h.
+ *
+ * kcdata_init_compress_bounded() is kcdata_init_compress() with a cap on the
+ * scratch memory used by the compressor: for KCDCT_ZLIB, the deflate window
+ * and hash sizes are reduced until the state fits in @scratch_limit bytes.
+ * Pushed items are buffered and compressed once @chunk_size bytes are pending
+ * (or the compression window is closed), and each chunk ends with a zlib
+ * sync flush, so that a reader can inflate the buffer incrementally.
+ * A @scratch_limit or @chunk_size of 0 selects the defaults.
+ */
+kern_return_t kcdata_init_compress(kcdata_descriptor_t data, int hdr_tag,
+    void (*memcpy_f)(void *, const void *, size_t), uint64_t type);
+kern_return_t kcdata_init_compress_bounded(kcdata_descriptor_t data, int hdr_tag,
+    void (*memcpy_f)(void *, const void *, size_t), uint64_t type,
+    size_t scratch_limit, uint32_t chunk_size);
+kern_return_t kcdata_push_data(kcdata_descriptor_t data, uint32_t type, uint32_t size, const void *input_data);
+kern_return_t kcdata_push_array(kcdata_descriptor_t data, uint32_t type_of_element,
+    uint32_t size_of_element, uint32_t count, const void *input_data);
+void kcdata_compression_window_open(kcdata_descriptor_t data);
+kern_return_t kcdata_compression_window_close(kcdata_descriptor_t data);
+kern_return_t kcdata_finish_compression(kcdata_descriptor_t data);
+void kcdata_deinit_compress(kcdata_descriptor_t data);
+
 #endif /* _KERN_CDATA_H_ */
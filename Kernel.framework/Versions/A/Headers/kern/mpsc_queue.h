@@ -31,6 +31,8 @@
 
 
 #include <sys/cdefs.h>
+#include <stdint.h>
+#include <mach/kern_return.h>
 
 __BEGIN_DECLS
 
@@ -121,6 +123,285 @@ typedef struct mpsc_queue_head {
  */
 #define MPSC_QUEUE_INITIALIZER(head)   { .mpqh_tail = &(head).mpqh_head }
 
+#pragma mark consumer interfaces
+
+/*!
+ * @function mpsc_queue_dequeue_batch()
+ *
+ * @brief
+ * Atomically empty a queue at once and return the batch head and tail.
+ *
+ * @discussion
+ * Consumer function, must be called in a serialized way with respect to any
+ * other consumer function.
+ *
+ * The whole chain is detached with a single atomic exchange of the tail,
+ * after which producers enqueue onto an empty queue again.
+ * The returned batch is a linked list of elements that must be walked with
+ * mpsc_queue_batch_next() or mpsc_queue_batch_foreach_safe(),
+ * as the last links may still be in the process of being published.
+ *
+ * @param q
+ * The queue
+ *
+ * @param tail
+ * An out pointer filled with the last element captured.
+ *
+ * @returns
+ * The first element of the batch if any, or NULL the queue was empty.
+ */
+extern mpsc_queue_chain_t
+mpsc_queue_dequeue_batch(mpsc_queue_head_t q, mpsc_queue_chain_t *tail);
+
+/*!
+ * @function mpsc_queue_batch_next()
+ *
+ * @brief
+ * Function used to consume an element from a batch dequeued with
+ * mpsc_queue_dequeue_batch().
+ *
+ * @discussion
+ * Once a batch has been dequeued, there is no need to hold the consumer lock
+ * anymore to consume it.
+ *
+ * mpsc_queue_batch_foreach_safe() is the preferred interface to consume
+ * the whole batch.
+ *
+ * @param cur
+ * The current inspected element of the batch (must be the batch head or
+ * a value returned by mpsc_queue_batch_next()).
+ *
+ * @param tail
+ * The last element of the batch.
+ *
+ * @returns
+ * The next element if any, NULL if @a cur is the batch tail.
+ */
+extern mpsc_queue_chain_t
+mpsc_queue_batch_next(mpsc_queue_chain_t cur, mpsc_queue_chain_t tail);
+
+/*!
+ * @macro mpsc_queue_batch_foreach_safe
+ *
+ * @brief
+ * Macro used to enumerate a batch dequeued with mpsc_queue_dequeue_batch().
+ *
+ * @param item
+ * The item being currently visited.
+ *
+ * @param head
+ * The first element of the batch.
+ *
+ * @param tail
+ * The last element of the batch.
+ */
+#define mpsc_queue_batch_foreach_safe(item, head, tail) \
+	for (mpsc_queue_chain_t __tmp, __item = (head), __tail = (tail); \
+	    __tmp = mpsc_queue_batch_next(__item, __tail), (item) = __item; \
+	    __item = __tmp)
+
+/*!
+ * @function mpsc_queue_restore_batch()
+ *
+ * @brief
+ * "Restore"s a batch at the head of the queue.
+ *
+ * @discussion
+ * Consumer function, must be called in a serialized way with respect to any
+ * other consumer function.
+ *
+ * This is used by consumers that stop draining a batch part way through,
+ * to put the unconsumed remainder back in front of newer elements.
+ *
+ * @param q
+ * The queue
+ *
+ * @param first
+ * The first element to put back.
+ *
+ * @param last
+ * The last element of the batch.
+ */
+extern void
+mpsc_queue_restore_batch(mpsc_queue_head_t q, mpsc_queue_chain_t first,
+    mpsc_queue_chain_t last);
+
+#pragma mark "GCD"-like facilities
+
+/*!
+ * @typedef struct mpsc_daemon_queue
+ *
+ * @brief
+ * Daemon queues are a ready-to use packaging of the low level MPSC queue
+ * primitive.
+ *
+ * @discussion
+ * mpsc_queue_t requires handling of state transitions of the queue and
+ * dequeuing yourself, which is a non trivial task.
+ *
+ * Daemon queues are a simple packaged solution that allows for mpsc_queue_t to
+ * form hierarchies (mostly for layering purposes), and be serviced at the
+ * bottom of such a hierarchy by a thread.
+ *
+ * By default each wakeup of the servicing thread drains the queue completely.
+ * mpsc_daemon_queue_set_batch_limit() bounds the number of elements drained
+ * per wakeup: the rest is put back with mpsc_queue_restore_batch() before
+ * the thread redrives itself, which bounds the latency a single busy daemon
+ * queue can impose on other work at the same priority.
+ */
+typedef struct mpsc_daemon_queue *mpsc_daemon_queue_t;
+
+/*!
+ * @typedef mpsc_daemon_invoke_fn_t
+ *
+ * @brief
+ * The type for MPSC Daemon Queues invoke callbacks.
+ */
+typedef void (*mpsc_daemon_invoke_fn_t)(mpsc_queue_chain_t elm,
+    mpsc_daemon_queue_t dq);
+
+/*!
+ * @enum mpsc_daemon_queue_kind
+ *
+ * @brief
+ * Internal type, not to be used by clients.
+ */
+__enum_decl(mpsc_daemon_queue_kind_t, uint16_t, {
+	MPSC_QUEUE_KIND_UNKNOWN,
+	MPSC_QUEUE_KIND_NESTED,
+	MPSC_QUEUE_KIND_THREAD,
+	MPSC_QUEUE_KIND_THREAD_CRITICAL,
+	MPSC_QUEUE_KIND_THREAD_CALL,
+});
+
+/*!
+ * @enum mpsc_daemon_queue_options
+ *
+ * @brief
+ * Options clients can set on their queue before first use.
+ *
+ * @const MPSC_QUEUE_OPTION_BATCH
+ * Call the `invoke` callback at the end of a batch
+ * with the magic @c MPSC_QUEUE_BATCH_END marker.
+ */
+__options_decl(mpsc_daemon_queue_options_t, uint16_t, {
+	MPSC_QUEUE_OPTION_BATCH  = 0x0001,
+});
+
+/*!
+ * @enum mpsc_daemon_queue_state
+ *
+ * @brief
+ * Internal type, not to be used by clients.
+ */
+__options_decl(mpsc_daemon_queue_state_t, uint32_t, {
+	MPSC_QUEUE_STATE_DRAINING = 0x0001,
+	MPSC_QUEUE_STATE_WAKEUP   = 0x0002,
+	MPSC_QUEUE_STATE_CANCELED = 0x0004,
+});
+
+struct mpsc_daemon_queue {
+	mpsc_daemon_queue_kind_t    mpd_kind;
+	mpsc_daemon_queue_options_t mpd_options;
+	mpsc_daemon_queue_state_t _Atomic mpd_state;
+	mpsc_daemon_invoke_fn_t     mpd_invoke;
+	struct thread              *mpd_thread;
+	struct mpsc_queue_head      mpd_queue;
+	struct mpsc_queue_chain     mpd_chain_link;
+};
+
+/*!
+ * @const MPSC_QUEUE_BATCH_END
+ *
+ * @brief
+ * The magic marker passed to the invoke callback of queues with
+ * MPSC_QUEUE_OPTION_BATCH set at the end of a batch.
+ */
+#define MPSC_QUEUE_BATCH_END  ((mpsc_queue_chain_t)~0ul)
+
+/*!
+ * @enum mpsc_queue_options
+ *
+ * @brief
+ * Options that can be passed to mpsc_daemon_enqueue().
+ *
+ * @const MPSC_QUEUE_NONE
+ * No options.
+ *
+ * @const MPSC_QUEUE_DISABLE_PREEMPTION
+ * Preemption is disabled by the caller already.
+ */
+typedef enum mpsc_queue_options {
+	MPSC_QUEUE_NONE                = 0,
+	MPSC_QUEUE_DISABLE_PREEMPTION  = 1 << 0,
+} mpsc_queue_options_t;
+
+/*!
+ * @function mpsc_daemon_queue_init_with_thread
+ *
+ * @brief
+ * Sets up a daemon queue which is a given thread.
+ *
+ * @param dq
+ * The queue to initialize
+ *
+ * @param invoke
+ * The invoke function called on individual items on the queue during drain.
+ *
+ * @param pri
+ * The scheduler priority for the created thread.
+ *
+ * @param name
+ * The name to give to the created thread.
+ *
+ * @returns
+ * Whether creating the thread was successful.
+ */
+extern kern_return_t
+mpsc_daemon_queue_init_with_thread(mpsc_daemon_queue_t dq,
+    mpsc_daemon_invoke_fn_t invoke, int pri, const char *name);
+
+/*!
+ * @function mpsc_daemon_queue_set_batch_limit
+ *
+ * @brief
+ * Bounds the number of elements drained per wakeup of the servicing thread.
+ *
+ * @discussion
+ * Must be called before the queue is first enqueued onto.
+ * The limit is kept by the kernel outside of struct mpsc_daemon_queue,
+ * whose layout is unchanged.
+ *
+ * @param dq
+ * The daemon queue to configure.
+ *
+ * @param limit
+ * The maximum number of elements drained per wakeup, 0 for no limit
+ * (the default).
+ */
+extern void
+mpsc_daemon_queue_set_batch_limit(mpsc_daemon_queue_t dq, uint32_t limit);
+
+/*!
+ * @function mpsc_daemon_enqueue
+ *
+ * @brief
+ * Publishes an element on a daemon queue and wakes up the servicing thread
+ * if needed.
+ *
+ * @param dq
+ * The daemon queue to enqueue the element onto.
+ *
+ * @param elm
+ * The element to enqueue.
+ *
+ * @param options
+ * Options applicable to the enqueue.
+ */
+extern void
+mpsc_daemon_enqueue(mpsc_daemon_queue_t dq, mpsc_queue_chain_t elm,
+    mpsc_queue_options_t options);
+
 
 __END_DECLS
 
@@ -97,9 +97,14 @@ typedef OSDictionary* OSDictionaryPtr;
  * An OSDictionary also grows as necessary to accommodate new key/value pairs,
  * <i>unlike</i> Core Foundation collections (it does not, however, shrink).
  *
- * <b>Note:</b> OSDictionary currently uses a linear search algorithm,
- * and is not designed for high-performance access of many values.
- * It is intended as a simple associative-storage mechanism only.
+ * <b>Note:</b> Small dictionaries are searched linearly.
+ * Once a dictionary holds more than
+ * <code>kOSDictionaryHashIndexThreshold</code> entries,
+ * an open-addressing hash index keyed on the OSSymbol pointer
+ * is built alongside the entry array and used for lookups,
+ * insertions and removals.
+ * The entry array remains the backing store,
+ * so iteration order is unaffected by the index.
  *
  * <b>Use Restrictions</b>
  *
@@ -153,6 +158,23 @@ protected:
 
 #endif /* APPLE_KEXT_ALIGN_CONTAINERS */
 
+/*
+ * The hash index is an open-addressing table of entry numbers
+ * (index + 1 into dictionary, 0 meaning an empty slot)
+ * probed linearly from the hashed key pointer.
+ * It is stored in the same allocation as the entry array,
+ * immediately after its capacity entries, and exists only
+ * while count exceeds kOSDictionaryHashIndexThreshold;
+ * no instance variable refers to it, so the object layout
+ * is unchanged.
+ * Its capacity is a power of two kept at no more than
+ * half full, and it is rebuilt whenever the entry array
+ * is reallocated or compacted by a removal.
+ */
+	bool         rebuildHashIndex(void);
+	void         freeHashIndex(void);
+	unsigned int findKeyIndex(const OSSymbol * aKey) const;
+
 // Member functions used by the OSCollectionIterator class.
 	virtual unsigned int iteratorSize() const APPLE_KEXT_OVERRIDE;
 	virtual bool initIterator(void * iterator) const APPLE_KEXT_OVERRIDE;
@@ -160,6 +182,21 @@ protected:
 
 public:
 
+/*!
+ * @enum kOSDictionaryHashIndexThreshold
+ *
+ * @abstract
+ * The entry count above which an OSDictionary maintains a hash index.
+ *
+ * @discussion
+ * Below this size a linear scan over the entry array
+ * touches fewer cache lines than a hashed probe.
+ * The index is built when the count grows past the threshold
+ * and dropped again by
+ * <code>@link flushCollection flushCollection@/link</code>.
+ */
+	enum { kOSDictionaryHashIndexThreshold = 32 };
+
 /*!
  * @function withCapacity
  *
@@ -571,6 +608,7 @@ public:
  * @discussion
  * The dictionary's capacity (and therefore direct memory consumption)
  * is not reduced by this function.
+ * Any hash index is released.
  */
 	virtual void flushCollection() APPLE_KEXT_OVERRIDE;
 
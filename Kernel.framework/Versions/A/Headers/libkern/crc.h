@@ -37,6 +37,24 @@ __BEGIN_DECLS
 uint16_t        crc16(uint16_t crc, const void *bufp, size_t len);
 uint32_t        crc32(uint32_t crc, const void *bufp, size_t len);
 
+/*
+ * CRC-32C (Castagnoli, reflected polynomial 0x82f63b78), as used by iSCSI
+ * and ext4.  Like crc32(), the running value is passed in and returned,
+ * starting from 0.
+ *
+ * Both CRCs use the SSE4.2 crc32 instruction (crc32c only) or carry-less
+ * multiplication folding when available, and slicing-by-8 tables otherwise.
+ */
+uint32_t        crc32c(uint32_t crc, const void *bufp, size_t len);
+
+/*
+ * Returns the CRC of the concatenation of two buffers, given crc1 of the
+ * first one and crc2 of the second one (computed from 0), of length len2.
+ * This lets buffers be checksummed in chunks, in parallel.
+ */
+uint32_t        crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+uint32_t        crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 __END_DECLS
 
 #endif /* _LIBKERN_CRC_H_ */
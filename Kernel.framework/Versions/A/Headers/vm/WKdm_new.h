@@ -70,10 +70,16 @@ extern "C" {
 
 
 #define WKdm_SCRATCH_BUF_SIZE_INTERNAL  PAGE_SIZE
+/*
+ * The 16k variants need a scratch buffer of this size; on x86_64, where
+ * they are the AVX2 implementations, it is larger than
+ * WKdm_SCRATCH_BUF_SIZE_INTERNAL.
+ */
+#define WKdm_SCRATCH_BUF_SIZE_16K       (16 * 1024)
 
 typedef unsigned int WK_word;
 
-#if defined(__arm64__)
+#if defined(__arm64__) || defined(__x86_64__)
 
 void
 WKdm_decompress_4k(const WK_word* src_buf,
@@ -96,7 +102,9 @@ WKdm_compress_16k(WK_word* src_buf,
     WK_word* dest_buf,
     WK_word* scratch,
     unsigned int limit);
-#else
+#endif
+
+#if !defined(__arm64__)
 
 void
 WKdm_decompress_new(WK_word* src_buf,
@@ -411,4 +411,358 @@ bitmap_lsb_next(const bitmap_t *map, uint nbits, uint prev)
 	return -1;
 }
 
+/*
+ * Bulk operations.
+ *
+ * These process four words (256 bits) per iteration with no dependency
+ * between the words, which lets the compiler emit wide vector operations
+ * where the target allows them.  The kernel is built without the AVX
+ * register file enabled, so they are written in plain C rather than with
+ * intrinsics.
+ */
+inline static void
+bitmap_or(bitmap_t *out, const bitmap_t *in1, const bitmap_t *in2, uint nbits)
+{
+	uint len = BITMAP_LEN(nbits);
+	uint i = 0;
+
+	for (; i + 4 <= len; i += 4) {
+		out[i + 0] = in1[i + 0] | in2[i + 0];
+		out[i + 1] = in1[i + 1] | in2[i + 1];
+		out[i + 2] = in1[i + 2] | in2[i + 2];
+		out[i + 3] = in1[i + 3] | in2[i + 3];
+	}
+	for (; i < len; i++) {
+		out[i] = in1[i] | in2[i];
+	}
+}
+
+/* Returns the number of '1' bits in the bitmap */
+inline static uint
+bitmap_count(const bitmap_t *map, uint nbits)
+{
+	uint len = BITMAP_LEN(nbits);
+	uint c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+	uint i = 0;
+
+	for (; i + 4 <= len; i += 4) {
+		c0 += (uint)bit_count(map[i + 0]);
+		c1 += (uint)bit_count(map[i + 1]);
+		c2 += (uint)bit_count(map[i + 2]);
+		c3 += (uint)bit_count(map[i + 3]);
+	}
+	for (; i < len; i++) {
+		c0 += (uint)bit_count(map[i]);
+	}
+
+	return c0 + c1 + c2 + c3;
+}
+
+/* Returns the number of '1' bits in (in1 & in2), without storing it */
+inline static uint
+bitmap_and_count(const bitmap_t *in1, const bitmap_t *in2, uint nbits)
+{
+	uint len = BITMAP_LEN(nbits);
+	uint c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+	uint i = 0;
+
+	for (; i + 4 <= len; i += 4) {
+		c0 += (uint)bit_count(in1[i + 0] & in2[i + 0]);
+		c1 += (uint)bit_count(in1[i + 1] & in2[i + 1]);
+		c2 += (uint)bit_count(in1[i + 2] & in2[i + 2]);
+		c3 += (uint)bit_count(in1[i + 3] & in2[i + 3]);
+	}
+	for (; i < len; i++) {
+		c0 += (uint)bit_count(in1[i] & in2[i]);
+	}
+
+	return c0 + c1 + c2 + c3;
+}
+
+/*
+ * Returns the least significant bit at or above `from` whose value is `value`,
+ * or -1 if no such bit exists.
+ */
+inline static int
+bitmap_lsb_first_from(const bitmap_t *map, uint nbits, uint from, bool value)
+{
+	if (from >= nbits) {
+		return -1;
+	}
+
+	uint64_t flip = value ? 0 : ~0ULL;
+	uint i = bitmap_index(from);
+	uint64_t word = (map[i] ^ flip) & ~mask(bitmap_bit(from));
+
+	for (;;) {
+		if (word != 0) {
+			uint n = (i << 6) + (uint)lsb_first(word);
+			return n < nbits ? (int)n : -1;
+		}
+		if (++i > bitmap_index(nbits - 1)) {
+			return -1;
+		}
+		word = map[i] ^ flip;
+	}
+}
+
+/*
+ * Returns the index of the lowest run of `len` consecutive '0' bits,
+ * or -1 if there is none.
+ *
+ * Runs are located a word at a time: fully set and fully clear words
+ * are skipped or accounted for in one step.
+ */
+inline static int
+bitmap_find_clear_run(const bitmap_t *map, uint nbits, uint len)
+{
+	uint from = 0;
+
+	assert(len > 0);
+	while (from + len <= nbits) {
+		int start = bitmap_lsb_first_from(map, nbits, from, false);
+		if (start < 0 || (uint)start + len > nbits) {
+			return -1;
+		}
+
+		int end = bitmap_lsb_first_from(map, nbits, (uint)start, true);
+		if (end < 0) {
+			end = (int)nbits;
+		}
+		if ((uint)(end - start) >= len) {
+			return start;
+		}
+		from = (uint)end;
+	}
+
+	return -1;
+}
+
+/*
+ * Hierarchical bitmaps
+ *
+ * A hierarchical bitmap is a flat bitmap (level 0) with two stacks of
+ * summary bitmaps on top of it.  In the "any" stack, bit i of level l is
+ * set when word i of level l - 1 is non zero.  In the "free" stack, bit i
+ * of level 1 is set when word i of the flat bitmap has a '0' bit, and
+ * bit i of level l > 1 is set when word i of level l - 1 is non zero.
+ *
+ * Each level is 64 times smaller than the one below it, and levels are
+ * added until the top one fits in a single word, so that
+ * HBITMAP_MAX_LEVELS levels cover up to 2^30 bits.  Finding the first set
+ * bit, or the next set or clear bit after a given one, only inspects
+ * one word per level and is O(1) for a given size class.
+ *
+ * Updates touch the summaries only when a word becomes empty, non
+ * empty, full or non full, so setting and clearing stay cheap.
+ */
+#define HBITMAP_MAX_LEVELS      5
+
+typedef struct hbitmap {
+	uint            hb_nbits;
+	uint            hb_levels;
+	bitmap_t       *hb_any[HBITMAP_MAX_LEVELS];
+	bitmap_t       *hb_free[HBITMAP_MAX_LEVELS];
+	size_t          hb_size;
+} hbitmap_t;
+
+/* Number of bits in level l of a hierarchical bitmap of nbits */
+inline static uint
+hbitmap_level_bits(uint nbits, uint l)
+{
+	uint64_t n = nbits;
+
+	while (l-- > 0) {
+		n = (n + 63) >> 6;
+	}
+	return (uint)n;
+}
+
+/* Mask of the valid bits of word i of the flat bitmap */
+inline static uint64_t
+hbitmap_valid(const hbitmap_t *hb, uint i)
+{
+	if (i < bitmap_index(hb->hb_nbits - 1)) {
+		return ~0ULL;
+	}
+	return mask(hb->hb_nbits - (i << 6));
+}
+
+inline static uint64_t
+hbitmap_free_word(const hbitmap_t *hb, uint l, uint i)
+{
+	if (l == 0) {
+		return ~hb->hb_any[0][i] & hbitmap_valid(hb, i);
+	}
+	return hb->hb_free[l][i];
+}
+
+inline static bool
+hbitmap_init(hbitmap_t *hb, uint nbits)
+{
+	size_t size = 0;
+	bitmap_t *map;
+	uint l;
+
+	assert(nbits > 0);
+	for (l = 0; ; l++) {
+		assert(l < HBITMAP_MAX_LEVELS);
+		size += BITMAP_SIZE(hbitmap_level_bits(nbits, l));
+		if (l > 0) {
+			size += BITMAP_SIZE(hbitmap_level_bits(nbits, l));
+		}
+		if (hbitmap_level_bits(nbits, l) <= 64) {
+			break;
+		}
+	}
+
+	map = (bitmap_t *)kalloc(size);
+	if (map == NULL) {
+		return false;
+	}
+	memset(map, 0, size);
+
+	hb->hb_nbits = nbits;
+	hb->hb_levels = l + 1;
+	hb->hb_size = size;
+	hb->hb_free[0] = NULL;
+	for (l = 0; l < hb->hb_levels; l++) {
+		uint lbits = hbitmap_level_bits(nbits, l);
+
+		hb->hb_any[l] = map;
+		map += BITMAP_LEN(lbits);
+		if (l > 0) {
+			hb->hb_free[l] = map;
+			map += BITMAP_LEN(lbits);
+			bitmap_full(hb->hb_free[l], lbits);
+		}
+	}
+	return true;
+}
+
+inline static void
+hbitmap_destroy(hbitmap_t *hb)
+{
+	kfree(hb->hb_any[0], hb->hb_size);
+	hb->hb_any[0] = NULL;
+}
+
+inline static bool
+hbitmap_test(const hbitmap_t *hb, uint n)
+{
+	return bitmap_test(hb->hb_any[0], n);
+}
+
+inline static void
+hbitmap_set(hbitmap_t *hb, uint n)
+{
+	uint i = bitmap_index(n);
+	uint64_t old = hb->hb_any[0][i];
+	uint64_t val = old | BIT(bitmap_bit(n));
+
+	if (old == val) {
+		return;
+	}
+	hb->hb_any[0][i] = val;
+
+	for (uint l = 1, j = i; old == 0 && l < hb->hb_levels; l++, j >>= 6) {
+		old = hb->hb_any[l][bitmap_index(j)];
+		bitmap_set(hb->hb_any[l], j);
+	}
+	if (val == hbitmap_valid(hb, i)) {
+		for (uint l = 1, j = i; l < hb->hb_levels; l++, j >>= 6) {
+			bitmap_clear(hb->hb_free[l], j);
+			if (hb->hb_free[l][bitmap_index(j)] != 0) {
+				break;
+			}
+		}
+	}
+}
+
+inline static void
+hbitmap_clear(hbitmap_t *hb, uint n)
+{
+	uint i = bitmap_index(n);
+	uint64_t old = hb->hb_any[0][i];
+	uint64_t val = old & ~BIT(bitmap_bit(n));
+
+	if (old == val) {
+		return;
+	}
+	hb->hb_any[0][i] = val;
+
+	if (val == 0) {
+		for (uint l = 1, j = i; l < hb->hb_levels; l++, j >>= 6) {
+			bitmap_clear(hb->hb_any[l], j);
+			if (hb->hb_any[l][bitmap_index(j)] != 0) {
+				break;
+			}
+		}
+	}
+	if (old == hbitmap_valid(hb, i)) {
+		old = 0;
+		for (uint l = 1, j = i; old == 0 && l < hb->hb_levels; l++, j >>= 6) {
+			old = hb->hb_free[l][bitmap_index(j)];
+			bitmap_set(hb->hb_free[l], j);
+		}
+	}
+}
+
+inline static uint64_t
+__hbitmap_word(const hbitmap_t *hb, uint l, uint i, bool value)
+{
+	return value ? hb->hb_any[l][i] : hbitmap_free_word(hb, l, i);
+}
+
+/*
+ * Returns the least significant bit at or above `from` whose value is `value`,
+ * or -1 if no such bit exists.
+ */
+inline static int
+hbitmap_lsb_next(const hbitmap_t *hb, uint from, bool value)
+{
+	uint pos = from;
+
+	if (from >= hb->hb_nbits) {
+		return -1;
+	}
+
+	for (uint l = 0; l < hb->hb_levels; l++) {
+		uint i = bitmap_index(pos);
+		uint64_t word = __hbitmap_word(hb, l, i, value) &
+		    ~mask(bitmap_bit(pos));
+
+		if (word != 0) {
+			pos = (i << 6) + (uint)lsb_first(word);
+			while (l-- > 0) {
+				word = __hbitmap_word(hb, l, pos, value);
+				pos = (pos << 6) + (uint)lsb_first(word);
+			}
+			return (int)pos;
+		}
+
+		pos = i + 1;
+		if (l + 1 < hb->hb_levels &&
+		    pos >= hbitmap_level_bits(hb->hb_nbits, l + 1)) {
+			break;
+		}
+	}
+
+	return -1;
+}
+
+/* Returns the least significant '1' bit, or -1 if all zeros */
+inline static int
+hbitmap_lsb_first(const hbitmap_t *hb)
+{
+	return hbitmap_lsb_next(hb, 0, true);
+}
+
+/* Returns the least significant '0' bit at or above `from`, or -1 if none */
+inline static int
+hbitmap_lsb_next_zero(const hbitmap_t *hb, uint from)
+{
+	return hbitmap_lsb_next(hb, from, false);
+}
+
 #endif
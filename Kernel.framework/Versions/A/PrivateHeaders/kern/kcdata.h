@@ -236,6 +236,12 @@
  * Once you are done with the kcdata buffer, call kcdata_deinit_compress to
  * free any buffers that may have been allocated internal to the compression
  * algorithm.
+ *
+ * kcdata_init_compress_bounded() additionally caps the compressor scratch
+ * memory and the amount of data compressed at once; each chunk is flushed so
+ * that readers can inflate it on its own. On the reading side, a kcdata_stream_t
+ * (see below) yields the items of the decompressed stream one at a time from
+ * a fixed size window, without inflating the whole buffer first.
  */
 
 
@@ -1386,4 +1392,454 @@ kcdata_iter_get_data_with_desc(kcdata_iter_t iter, char **desc_ptr, void **data_
 	}
 }
 
+/**************** random access index *********************/
+
+/*
+ * A kcdata index is built in one pass over a buffer, and records every item
+ * in a compact table so that later lookups do not need to walk the buffer:
+ *
+ * - kcdata_index_find_container() finds a container by (type, id) in O(1),
+ *   for example STACKSHOT_KCCONTAINER_THREAD with a given thread id,
+ *
+ * - kcdata_index_find_child() finds an item of a given type directly inside
+ *   a container, skipping over nested containers,
+ *
+ * - kcdata_index_first_of_type() and kcdata_index_next_of_type() visit all
+ *   the items of a given type in buffer order.
+ *
+ * All bounds, arrays and container nesting are validated once while
+ * building the index; iterators returned by kcdata_index_iter() can then be
+ * used without checking kcdata_iter_valid() again.  The buffer is never
+ * copied or modified, so it may be a read-only mapping of a file.
+ *
+ * The index uses caller provided storage: kcdata_index_count_items() returns
+ * the number of items in a buffer, and kcdata_index_storage_size() the
+ * number of bytes needed to index that many items.
+ */
+
+#define KCDATA_INDEX_NONE       UINT32_MAX
+
+struct kcdata_index_entry {
+	uint32_t kie_offset;    /* offset of the item in the buffer */
+	uint32_t kie_type;      /* kcdata_iter_type() of the item */
+	uint32_t kie_parent;    /* enclosing container entry, or KCDATA_INDEX_NONE */
+	uint32_t kie_end;       /* for containers, entry of the matching CONTAINER_END */
+	uint32_t kie_next_type; /* next entry with the same type, or KCDATA_INDEX_NONE */
+};
+
+typedef struct kcdata_index {
+	void                      *kci_buffer;
+	unsigned long              kci_size;
+	struct kcdata_index_entry *kci_entries;
+	uint32_t                  *kci_slots;   /* open addressing hash, entry + 1 */
+	uint32_t                   kci_count;
+	uint32_t                   kci_nslots;
+} kcdata_index_t;
+
+static inline
+uint32_t
+kcdata_index_hash_slots(uint32_t count)
+{
+	uint32_t nslots = 16;
+	while (nslots < 2 * count && nslots < (1u << 31)) {
+		nslots <<= 1;
+	}
+	return nslots;
+}
+
+static inline
+unsigned long
+kcdata_index_storage_size(uint32_t count)
+{
+	return count * sizeof(struct kcdata_index_entry) +
+	       kcdata_index_hash_slots(count) * sizeof(uint32_t);
+}
+
+/*
+ * Returns the number of items in the buffer, including the trailing
+ * KCDATA_TYPE_BUFFER_END item, or 0 if the buffer is malformed.
+ */
+static inline
+uint32_t
+kcdata_index_count_items(void *buffer, unsigned long size)
+{
+	kcdata_iter_t iter = kcdata_iter(buffer, size);
+	uint32_t count = 0;
+
+	if (size > UINT32_MAX) {
+		return 0;
+	}
+	KCDATA_ITER_FOREACH(iter) {
+		count++;
+	}
+	if (KCDATA_ITER_FOREACH_FAILED(iter)) {
+		return 0;
+	}
+	return count + 1;
+}
+
+static inline
+kcdata_iter_t
+kcdata_index_iter(const kcdata_index_t *idx, uint32_t entry)
+{
+	return kcdata_iter((char *)idx->kci_buffer + idx->kci_entries[entry].kie_offset,
+	           idx->kci_size - idx->kci_entries[entry].kie_offset);
+}
+
+static inline
+uint32_t
+kcdata_index_hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return (uint32_t)key;
+}
+
+/*
+ * Containers are keyed on (container type, id), and type chains on the item
+ * type alone; the two are told apart by the entry they point to.
+ */
+static inline
+uint64_t
+kcdata_index_container_key(uint32_t container_type, uint64_t id)
+{
+	return (id * 0x9e3779b97f4a7c15ull) ^ container_type;
+}
+
+static inline
+int
+kcdata_index_slot_matches(const kcdata_index_t *idx, uint32_t entry,
+    int container, uint32_t type, uint64_t id)
+{
+	const struct kcdata_index_entry *e = &idx->kci_entries[entry];
+
+	if (!container) {
+		return e->kie_type == type && e->kie_end == KCDATA_INDEX_NONE;
+	}
+	if (e->kie_type != KCDATA_TYPE_CONTAINER_BEGIN) {
+		return 0;
+	}
+	kcdata_iter_t iter = kcdata_index_iter(idx, entry);
+	return kcdata_iter_container_type(iter) == type &&
+	       kcdata_iter_container_id(iter) == id;
+}
+
+static inline
+uint32_t *
+kcdata_index_slot(const kcdata_index_t *idx, int container, uint32_t type, uint64_t id)
+{
+	uint64_t key = container ? kcdata_index_container_key(type, id) : type;
+	uint32_t mask = idx->kci_nslots - 1;
+	uint32_t i = kcdata_index_hash(key) & mask;
+
+	while (idx->kci_slots[i] != 0 &&
+	    !kcdata_index_slot_matches(idx, idx->kci_slots[i] - 1, container, type, id)) {
+		i = (i + 1) & mask;
+	}
+	return &idx->kci_slots[i];
+}
+
+/*
+ * Builds an index of the buffer into storage, which must be at least
+ * kcdata_index_storage_size(count) bytes and aligned for uint32_t, where
+ * count is the value returned by kcdata_index_count_items().
+ *
+ * Returns 1 if the buffer was fully validated and indexed, 0 otherwise.
+ * Compressed buffers must be decompressed before they can be indexed.
+ */
+static inline
+int
+kcdata_index_build(kcdata_index_t *idx, void *buffer, unsigned long size,
+    void *storage, uint32_t count)
+{
+	kcdata_iter_t iter = kcdata_iter(buffer, size);
+	uint32_t parent = KCDATA_INDEX_NONE;
+	uint32_t n = 0;
+
+	if (count == 0 || size > UINT32_MAX) {
+		return 0;
+	}
+	idx->kci_buffer = buffer;
+	idx->kci_size = size;
+	idx->kci_entries = (struct kcdata_index_entry *)storage;
+	idx->kci_slots = (uint32_t *)(idx->kci_entries + count);
+	idx->kci_nslots = kcdata_index_hash_slots(count);
+	idx->kci_count = 0;
+	memset(idx->kci_slots, 0, idx->kci_nslots * sizeof(uint32_t));
+
+	if (!kcdata_iter_valid(iter) ||
+	    kcdata_iter_type(iter) == KCDATA_BUFFER_BEGIN_COMPRESSED) {
+		return 0;
+	}
+
+	for (;; iter = kcdata_iter_next(iter)) {
+		struct kcdata_index_entry *e = &idx->kci_entries[n];
+		uint32_t type;
+
+		if (n == count || !kcdata_iter_valid(iter)) {
+			return 0;
+		}
+		type = kcdata_iter_type(iter);
+		if (type == KCDATA_TYPE_ARRAY && !kcdata_iter_array_valid(iter)) {
+			return 0;
+		}
+
+		e->kie_offset = (uint32_t)((uintptr_t)iter.item - (uintptr_t)buffer);
+		e->kie_type = type;
+		e->kie_parent = parent;
+		e->kie_end = KCDATA_INDEX_NONE;
+		e->kie_next_type = KCDATA_INDEX_NONE;
+
+		if (type == KCDATA_TYPE_CONTAINER_BEGIN) {
+			if (!kcdata_iter_container_valid(iter)) {
+				return 0;
+			}
+			e->kie_end = n;         /* open, fixed up on CONTAINER_END */
+			parent = n;
+		} else if (type == KCDATA_TYPE_CONTAINER_END) {
+			kcdata_iter_t begin;
+
+			if (parent == KCDATA_INDEX_NONE) {
+				return 0;
+			}
+			begin = kcdata_index_iter(idx, parent);
+			if (kcdata_iter_container_id(begin) != kcdata_iter_container_id(iter)) {
+				return 0;
+			}
+			e->kie_parent = idx->kci_entries[parent].kie_parent;
+			idx->kci_entries[parent].kie_end = n;
+			parent = e->kie_parent;
+		}
+		n++;
+
+		if (type == KCDATA_TYPE_BUFFER_END) {
+			break;
+		}
+	}
+	if (parent != KCDATA_INDEX_NONE) {
+		return 0;
+	}
+	idx->kci_count = n;
+
+	/* build the type chains back to front so that they end up in order */
+	for (uint32_t i = n; i-- > 0;) {
+		struct kcdata_index_entry *e = &idx->kci_entries[i];
+		uint32_t *slot;
+
+		if (e->kie_type == KCDATA_TYPE_CONTAINER_BEGIN) {
+			kcdata_iter_t begin = kcdata_index_iter(idx, i);
+			slot = kcdata_index_slot(idx, 1, kcdata_iter_container_type(begin),
+			    kcdata_iter_container_id(begin));
+			*slot = i + 1;
+		} else {
+			slot = kcdata_index_slot(idx, 0, e->kie_type, 0);
+			e->kie_next_type = *slot ? *slot - 1 : KCDATA_INDEX_NONE;
+			*slot = i + 1;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Returns the entry of the container with the given container type and id,
+ * or KCDATA_INDEX_NONE.
+ */
+static inline
+uint32_t
+kcdata_index_find_container(const kcdata_index_t *idx, uint32_t container_type, uint64_t id)
+{
+	return *kcdata_index_slot(idx, 1, container_type, id) - 1;
+}
+
+/*
+ * Returns the first entry of the given type, or KCDATA_INDEX_NONE.
+ * Containers are looked up with kcdata_index_find_container() instead.
+ */
+static inline
+uint32_t
+kcdata_index_first_of_type(const kcdata_index_t *idx, uint32_t type)
+{
+	return *kcdata_index_slot(idx, 0, type, 0) - 1;
+}
+
+static inline
+uint32_t
+kcdata_index_next_of_type(const kcdata_index_t *idx, uint32_t entry)
+{
+	return idx->kci_entries[entry].kie_next_type;
+}
+
+/*
+ * Returns the first item of the given type directly inside the container
+ * (not inside a nested container), or KCDATA_INDEX_NONE.
+ */
+static inline
+uint32_t
+kcdata_index_find_child(const kcdata_index_t *idx, uint32_t container, uint32_t type)
+{
+	uint32_t end = idx->kci_entries[container].kie_end;
+
+	for (uint32_t i = container + 1; i < end;) {
+		const struct kcdata_index_entry *e = &idx->kci_entries[i];
+
+		if (e->kie_type == type) {
+			return i;
+		}
+		i = e->kie_type == KCDATA_TYPE_CONTAINER_BEGIN ? e->kie_end + 1 : i + 1;
+	}
+	return KCDATA_INDEX_NONE;
+}
+
+/**************** streaming reader *********************/
+
+/*
+ * A kcdata stream hands out the items of a kcdata buffer that is produced
+ * incrementally, typically by inflating a KCDATA_BUFFER_BEGIN_COMPRESSED
+ * buffer chunk by chunk, without materializing the whole buffer.
+ *
+ * The stream itself does not decompress: it only parses items out of the
+ * bytes returned by the fill function.  For a compressed buffer, the caller
+ * first uses kcdata_stream_compressed_payload() to skip the
+ * KCDATA_BUFFER_BEGIN_COMPRESSED item and the descriptor items that follow
+ * it, and to learn the compression type; the fill function then runs the
+ * matching decompressor (inflate for KCDCT_ZLIB, a plain copy for
+ * KCDCT_NONE) over the bytes from the returned payload offset on.
+ *
+ * The fill function is called to append up to @len decompressed bytes at
+ * @dst, and returns the number of bytes produced, or 0 at the end of the
+ * stream.  Items are made contiguous in a caller provided window, which must
+ * be 16 byte aligned and larger than the largest item in the stream.
+ *
+ * kcdata_stream_next() returns an iterator on the next item, which stays
+ * valid until the following call, or kcdata_invalid_iter at the end of the
+ * stream or if an item does not fit in the window.
+ */
+typedef size_t (*kcdata_stream_fill_fn_t)(void *ctx, void *dst, size_t len);
+
+typedef struct kcdata_stream {
+	kcdata_stream_fill_fn_t kst_fill;
+	void   *kst_ctx;
+	char   *kst_window;
+	size_t  kst_window_size;
+	size_t  kst_start;      /* offset of the next item in the window */
+	size_t  kst_end;        /* number of valid bytes in the window */
+	int     kst_eof;
+} kcdata_stream_t;
+
+static inline
+void
+kcdata_stream_init(kcdata_stream_t *st, void *window, size_t window_size,
+    kcdata_stream_fill_fn_t fill, void *ctx)
+{
+	st->kst_fill = fill;
+	st->kst_ctx = ctx;
+	st->kst_window = (char *)window;
+	st->kst_window_size = window_size;
+	st->kst_start = 0;
+	st->kst_end = 0;
+	st->kst_eof = 0;
+}
+
+/* Makes at least len bytes available at kst_start */
+static inline
+int
+kcdata_stream_ensure(kcdata_stream_t *st, size_t len)
+{
+	if (st->kst_end - st->kst_start >= len) {
+		return 1;
+	}
+	if (len > st->kst_window_size) {
+		return 0;
+	}
+	if (st->kst_start > 0) {
+		memmove(st->kst_window, st->kst_window + st->kst_start,
+		    st->kst_end - st->kst_start);
+		st->kst_end -= st->kst_start;
+		st->kst_start = 0;
+	}
+	while (st->kst_end < len) {
+		size_t n;
+
+		if (st->kst_eof) {
+			return 0;
+		}
+		n = st->kst_fill(st->kst_ctx, st->kst_window + st->kst_end,
+		    st->kst_window_size - st->kst_end);
+		if (n == 0) {
+			st->kst_eof = 1;
+			return 0;
+		}
+		st->kst_end += n;
+	}
+	return 1;
+}
+
+static inline
+kcdata_iter_t
+kcdata_stream_next(kcdata_stream_t *st)
+{
+	kcdata_iter_t iter;
+	size_t total;
+
+	if (!kcdata_stream_ensure(st, sizeof(struct kcdata_item))) {
+		return kcdata_invalid_iter;
+	}
+	total = sizeof(struct kcdata_item) +
+	    ((kcdata_item_t)(st->kst_window + st->kst_start))->size;
+	if (!kcdata_stream_ensure(st, total)) {
+		return kcdata_invalid_iter;
+	}
+	iter = kcdata_iter(st->kst_window + st->kst_start, total);
+	st->kst_start += total;
+	return iter;
+}
+
+/*
+ * Parses the header of a KCDATA_BUFFER_BEGIN_COMPRESSED buffer: the begin
+ * item, followed by descriptor items (such as "kcd_c_type", the compression
+ * type) written by kcdata_init_compress().  Returns 1 and the offset of the
+ * first compressed byte in @payload_offset on success, 0 if the buffer does
+ * not start with KCDATA_BUFFER_BEGIN_COMPRESSED.  @comp_type is left
+ * untouched if the header does not record the compression type.
+ */
+static inline
+int
+kcdata_stream_compressed_payload(void *buffer, size_t size,
+    uint64_t *comp_type, size_t *payload_offset)
+{
+	kcdata_iter_t iter = kcdata_iter(buffer, size);
+
+	if (!kcdata_iter_valid(iter) ||
+	    kcdata_iter_type(iter) != KCDATA_BUFFER_BEGIN_COMPRESSED) {
+		return 0;
+	}
+	for (iter = kcdata_iter_next(iter); kcdata_iter_valid(iter);
+	    iter = kcdata_iter_next(iter)) {
+		uint32_t type = kcdata_iter_type(iter);
+		char *desc;
+		void *data;
+
+		if (type != KCDATA_TYPE_UINT32_DESC &&
+		    type != KCDATA_TYPE_UINT64_DESC &&
+		    type != KCDATA_TYPE_INT64_DESC) {
+			break;
+		}
+		if (kcdata_iter_data_with_desc_valid(iter, sizeof(uint64_t)) &&
+		    type != KCDATA_TYPE_UINT32_DESC) {
+			kcdata_iter_get_data_with_desc(iter, &desc, &data, NULL);
+			if (strcmp(desc, "kcd_c_type") == 0) {
+				memcpy(comp_type, data, sizeof(uint64_t));
+			}
+		}
+	}
+	*payload_offset = (size_t)((char *)iter.item - (char *)buffer);
+	return 1;
+}
+
+#define KCDATA_STREAM_FOREACH(st, iter) \
+	for ((iter) = kcdata_stream_next(st); \
+	    kcdata_iter_valid(iter) && (iter).item->type != KCDATA_TYPE_BUFFER_END; \
+	    (iter) = kcdata_stream_next(st))
+
 #endif
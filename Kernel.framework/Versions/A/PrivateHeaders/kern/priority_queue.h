@@ -78,6 +78,9 @@ __BEGIN_DECLS
  *         - generic, in which case a comparison function must be passed to
  *           the priority_queue_init.
  *
+ *         - deadline_dheap, in which case the key is a 64-bit deadline, and
+ *           the heap is an implicit 4-ary heap stored in an array (see below).
+ *
  * Element Linkage:
  *
  *         Both types use a common queue head and linkage pattern.
@@ -196,6 +199,40 @@ typedef struct priority_queue_entry_stable {
 
 #endif /* __LP64__ */
 
+/*
+ * Array backed heaps
+ *
+ *         The deadline_dheap queues do not link elements to each other.
+ *         Instead the queue owns an array of (key, element) slots, laid out
+ *         as an implicit 4-ary heap: the children of slot i are the slots
+ *         4i + 1 to 4i + 4.  With 16 byte slots, all the children of a node
+ *         share a single cache line, and sifting compares cached keys without
+ *         dereferencing any element.  This trades the O(1) insertion of the
+ *         pairing heaps for O(log4 n) with far fewer cache misses, which is
+ *         the better deal once tens of thousands of elements are queued.
+ *
+ *         Each element records the slot it currently occupies in pqe_index,
+ *         so priority_queue_remove() and the key change notifications are
+ *         O(log n) without any search.
+ *
+ *         The slot array is provided by the caller to priority_queue_init()
+ *         and can be replaced with a larger one using
+ *         priority_queue_dheap_resize().  priority_queue_heapify() builds
+ *         a queue from an array of elements in O(n).
+ */
+#define PRIORITY_QUEUE_DHEAP_ARITY          4
+#define PRIORITY_QUEUE_DHEAP_INDEX_NONE     UINT32_MAX
+
+typedef struct priority_queue_entry_dheap {
+	uint32_t                            pqe_index;
+	uint64_t                            deadline;
+} *priority_queue_entry_dheap_t;
+
+struct priority_queue_dheap_slot {
+	uint64_t                            pqs_key;
+	struct priority_queue_entry_dheap  *pqs_elt;
+};
+
 /*
  * Comparator block prototype
  * Args:
@@ -242,6 +279,25 @@ struct priority_queue_deadline_max {
 	struct priority_queue_entry_deadline *pq_root;
 };
 
+/*
+ * Type of array backed deadline heaps
+ *
+ * pq_root always mirrors pq_slots[0].pqs_elt (or NULL when empty),
+ * so that the generic accessors below work unchanged.
+ */
+struct priority_queue_deadline_dheap_min {
+	struct priority_queue_entry_dheap  *pq_root;
+	struct priority_queue_dheap_slot   *pq_slots;
+	uint32_t                            pq_count;
+	uint32_t                            pq_capacity;
+};
+struct priority_queue_deadline_dheap_max {
+	struct priority_queue_entry_dheap  *pq_root;
+	struct priority_queue_dheap_slot   *pq_slots;
+	uint32_t                            pq_count;
+	uint32_t                            pq_capacity;
+};
+
 /*
  * Type of scheduler priority based heaps
  */
@@ -273,6 +329,8 @@ struct priority_queue_sched_stable_max {
 	struct priority_queue_max *: false, \
 	struct priority_queue_deadline_min *: true, \
 	struct priority_queue_deadline_max *: false, \
+	struct priority_queue_deadline_dheap_min *: true, \
+	struct priority_queue_deadline_dheap_max *: false, \
 	struct priority_queue_sched_min *: true, \
 	struct priority_queue_sched_max *: false, \
 	struct priority_queue_sched_stable_min *: true, \
@@ -528,6 +586,54 @@ extern bool
 priority_queue_entry_increased(struct priority_queue *pq,
     struct priority_queue_entry *elt) __pqueue_overloadable;
 
+/*
+ *      Macro:          priority_queue_heapify
+ *
+ *      Function:
+ *              Replaces the contents of an array backed priority queue with
+ *              the given elements, in O(n).
+ *
+ *              The keys of the elements must have been set prior to calling
+ *              this function, and the queue must have room for all of them.
+ *
+ *      Header:
+ *              priority_queue_heapify(pq, elts, count)
+ *                      <struct priority_queue *> pq
+ *                      <priority_queue_entry_t *> elts
+ *                      <uint32_t> count
+ *      Returns:
+ *              None
+ */
+
+/*
+ *      Macro:          priority_queue_dheap_resize
+ *
+ *      Function:
+ *              Moves the contents of an array backed priority queue to a new
+ *              slot array, which must be able to hold all queued elements.
+ *              The old array is no longer referenced on return and can be
+ *              freed by the caller.
+ *
+ *      Header:
+ *              priority_queue_dheap_resize(pq, slots, capacity)
+ *                      <struct priority_queue *> pq
+ *                      <struct priority_queue_dheap_slot *> slots
+ *                      <uint32_t> capacity
+ *      Returns:
+ *              None
+ */
+
+/*
+ *      Macro:          priority_queue_dheap_full
+ *
+ *      Function:
+ *              Tests whether an array backed priority queue has no free slot.
+ *      Header:
+ *              boolean_t priority_queue_dheap_full(pq)
+ *                      <struct priority_queue *> pq
+ */
+#define priority_queue_dheap_full(pq)    ((pq)->pq_count == (pq)->pq_capacity)
+
 
 #pragma mark priority_queue_sched_*
 
@@ -687,12 +793,218 @@ priority_queue_init(pqueue_t pq, priority_queue_compare_fn_t cmp_fn)
                                                                                 \
 PRIORITY_QUEUE_MAKE_BASE(pqueue_t, pqelem_t)
 
+#define PRIORITY_QUEUE_DHEAP_PARENT(i)  (((i) - 1) / PRIORITY_QUEUE_DHEAP_ARITY)
+#define PRIORITY_QUEUE_DHEAP_CHILD(i)   ((i) * PRIORITY_QUEUE_DHEAP_ARITY + 1)
+
+static inline bool
+_priority_queue_dheap_before(bool is_min, uint64_t k1, uint64_t k2)
+{
+	return is_min ? k1 < k2 : k1 > k2;
+}
+
+static inline void
+_priority_queue_dheap_place(struct priority_queue_dheap_slot *slots,
+    uint32_t i, struct priority_queue_dheap_slot slot)
+{
+	slots[i] = slot;
+	slot.pqs_elt->pqe_index = i;
+}
+
+static inline uint32_t
+_priority_queue_dheap_sift_up(struct priority_queue_dheap_slot *slots,
+    uint32_t i, bool is_min)
+{
+	struct priority_queue_dheap_slot slot = slots[i];
+
+	while (i > 0) {
+		uint32_t parent = PRIORITY_QUEUE_DHEAP_PARENT(i);
+
+		if (!_priority_queue_dheap_before(is_min, slot.pqs_key,
+		    slots[parent].pqs_key)) {
+			break;
+		}
+		_priority_queue_dheap_place(slots, i, slots[parent]);
+		i = parent;
+	}
+	_priority_queue_dheap_place(slots, i, slot);
+	return i;
+}
+
+static inline uint32_t
+_priority_queue_dheap_sift_down(struct priority_queue_dheap_slot *slots,
+    uint32_t count, uint32_t i, bool is_min)
+{
+	struct priority_queue_dheap_slot slot = slots[i];
+
+	for (;;) {
+		uint32_t child = PRIORITY_QUEUE_DHEAP_CHILD(i);
+		uint32_t end, best;
+
+		if (child >= count) {
+			break;
+		}
+		end = child + PRIORITY_QUEUE_DHEAP_ARITY;
+		if (end > count) {
+			end = count;
+		}
+		for (best = child++; child < end; child++) {
+			if (_priority_queue_dheap_before(is_min, slots[child].pqs_key,
+			    slots[best].pqs_key)) {
+				best = child;
+			}
+		}
+		if (!_priority_queue_dheap_before(is_min, slots[best].pqs_key,
+		    slot.pqs_key)) {
+			break;
+		}
+		_priority_queue_dheap_place(slots, i, slots[best]);
+		i = best;
+	}
+	_priority_queue_dheap_place(slots, i, slot);
+	return i;
+}
+
+#define PRIORITY_QUEUE_MAKE_DHEAP(pqueue_t, pqelem_t, is_min) \
+__pqueue_overloadable                                                           \
+static inline void                                                              \
+priority_queue_init(pqueue_t que, struct priority_queue_dheap_slot *slots,      \
+    uint32_t capacity)                                                          \
+{                                                                               \
+	que->pq_root = NULL;                                                    \
+	que->pq_slots = slots;                                                  \
+	que->pq_count = 0;                                                      \
+	que->pq_capacity = capacity;                                            \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline void                                                              \
+_priority_queue_destroy(pqueue_t que, uintptr_t offset, void (^cb)(void *))     \
+{                                                                               \
+	for (uint32_t i = 0; i < que->pq_count; i++) {                          \
+		cb((void *)((uintptr_t)que->pq_slots[i].pqs_elt - offset));     \
+	}                                                                       \
+	que->pq_root = NULL;                                                    \
+	que->pq_count = 0;                                                      \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline bool                                                              \
+priority_queue_insert(pqueue_t que, pqelem_t elt)                               \
+{                                                                               \
+	uint32_t i = que->pq_count++;                                           \
+                                                                                \
+	assert(i < que->pq_capacity);                                           \
+	que->pq_slots[i].pqs_key = elt->deadline;                               \
+	que->pq_slots[i].pqs_elt = elt;                                         \
+	i = _priority_queue_dheap_sift_up(que->pq_slots, i, is_min);            \
+	que->pq_root = que->pq_slots[0].pqs_elt;                                \
+	return i == 0;                                                          \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline bool                                                              \
+priority_queue_remove(pqueue_t que, pqelem_t elt)                               \
+{                                                                               \
+	uint32_t i = elt->pqe_index;                                            \
+	uint32_t last = --que->pq_count;                                        \
+                                                                                \
+	assert(i <= last && que->pq_slots[i].pqs_elt == elt);                   \
+	if (i != last) {                                                        \
+		que->pq_slots[i] = que->pq_slots[last];                         \
+		if (_priority_queue_dheap_sift_up(que->pq_slots, i, is_min) == i) { \
+			_priority_queue_dheap_sift_down(que->pq_slots, last, i, is_min); \
+		}                                                               \
+	}                                                                       \
+	elt->pqe_index = PRIORITY_QUEUE_DHEAP_INDEX_NONE;                       \
+	que->pq_root = last ? que->pq_slots[0].pqs_elt : NULL;                  \
+	return i == 0;                                                          \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline pqelem_t                                                          \
+_priority_queue_remove_root(pqueue_t que)                                       \
+{                                                                               \
+	pqelem_t root = que->pq_root;                                           \
+                                                                                \
+	if (root) {                                                             \
+		priority_queue_remove(que, root);                               \
+	}                                                                       \
+	return root;                                                            \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline bool                                                              \
+priority_queue_entry_decreased(pqueue_t que, pqelem_t elt)                      \
+{                                                                               \
+	uint32_t i = elt->pqe_index, n;                                         \
+                                                                                \
+	que->pq_slots[i].pqs_key = elt->deadline;                               \
+	if (is_min) {                                                           \
+		n = _priority_queue_dheap_sift_up(que->pq_slots, i, is_min);    \
+	} else {                                                                \
+		n = _priority_queue_dheap_sift_down(que->pq_slots,              \
+		    que->pq_count, i, is_min);                                  \
+	}                                                                       \
+	que->pq_root = que->pq_slots[0].pqs_elt;                                \
+	return i == 0 || n == 0;                                                \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline bool                                                              \
+priority_queue_entry_increased(pqueue_t que, pqelem_t elt)                      \
+{                                                                               \
+	uint32_t i = elt->pqe_index, n;                                         \
+                                                                                \
+	que->pq_slots[i].pqs_key = elt->deadline;                               \
+	if (is_min) {                                                           \
+		n = _priority_queue_dheap_sift_down(que->pq_slots,              \
+		    que->pq_count, i, is_min);                                  \
+	} else {                                                                \
+		n = _priority_queue_dheap_sift_up(que->pq_slots, i, is_min);    \
+	}                                                                       \
+	que->pq_root = que->pq_slots[0].pqs_elt;                                \
+	return i == 0 || n == 0;                                                \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline void                                                              \
+priority_queue_heapify(pqueue_t que, pqelem_t *elts, uint32_t count)            \
+{                                                                               \
+	assert(count <= que->pq_capacity);                                      \
+	for (uint32_t i = 0; i < count; i++) {                                  \
+		que->pq_slots[i].pqs_key = elts[i]->deadline;                   \
+		que->pq_slots[i].pqs_elt = elts[i];                             \
+		elts[i]->pqe_index = i;                                         \
+	}                                                                       \
+	que->pq_count = count;                                                  \
+	for (uint32_t i = count > 1 ? PRIORITY_QUEUE_DHEAP_PARENT(count - 1) + 1 : 0; \
+	    i-- > 0;) {                                                         \
+		_priority_queue_dheap_sift_down(que->pq_slots, count, i, is_min); \
+	}                                                                       \
+	que->pq_root = count ? que->pq_slots[0].pqs_elt : NULL;                 \
+}                                                                               \
+                                                                                \
+__pqueue_overloadable                                                           \
+static inline void                                                              \
+priority_queue_dheap_resize(pqueue_t que, struct priority_queue_dheap_slot *slots, \
+    uint32_t capacity)                                                          \
+{                                                                               \
+	assert(capacity >= que->pq_count);                                      \
+	__builtin_memcpy(slots, que->pq_slots,                                  \
+	    que->pq_count * sizeof(struct priority_queue_dheap_slot));          \
+	que->pq_slots = slots;                                                  \
+	que->pq_capacity = capacity;                                            \
+}
+
 PRIORITY_QUEUE_MAKE_CB(struct priority_queue_min *, priority_queue_entry_t);
 PRIORITY_QUEUE_MAKE_CB(struct priority_queue_max *, priority_queue_entry_t);
 
 PRIORITY_QUEUE_MAKE(struct priority_queue_deadline_min *, priority_queue_entry_deadline_t);
 PRIORITY_QUEUE_MAKE(struct priority_queue_deadline_max *, priority_queue_entry_deadline_t);
 
+PRIORITY_QUEUE_MAKE_DHEAP(struct priority_queue_deadline_dheap_min *, priority_queue_entry_dheap_t, true);
+PRIORITY_QUEUE_MAKE_DHEAP(struct priority_queue_deadline_dheap_max *, priority_queue_entry_dheap_t, false);
+
 PRIORITY_QUEUE_MAKE(struct priority_queue_sched_min *, priority_queue_entry_sched_t);
 PRIORITY_QUEUE_MAKE(struct priority_queue_sched_max *, priority_queue_entry_sched_t);
 
@@ -69,6 +69,21 @@ typedef OSSymbol const* OSSymbolConstPtr;
  * it makes no effort to enforce immutability of that value.
  * Altering the contents of an OSSymbol should be avoided.
  *
+ * The pool of unique symbols is split into shards
+ * selected by the top bits of each string's hash.
+ * Every OSSymbol caches that hash when it is created,
+ * so lookups only hash the candidate string once
+ * and compare cached hashes before comparing characters.
+ * Lookups walk a shard without taking its lock;
+ * only insertion of a new symbol and removal of a dead one
+ * serialize, and only against the same shard.
+ * A lookup returns a symbol it found only if it can take a reference
+ * with a try-retain, which fails once the retain count has dropped to
+ * zero; a symbol whose last reference is being released concurrently
+ * is therefore treated as absent, and a new one is created in its place.
+ * Dead symbols are unlinked under the shard lock and freed only after
+ * lock-free readers can no longer be walking past them.
+ *
  * <b>Use Restrictions</b>
  *
  * With very few exceptions in the I/O Kit, all Libkern-based C++
@@ -92,6 +107,8 @@ class OSSymbol : public OSString
 
 private:
 
+	uint32_t       hashValue;
+
 	static void initialize();
 
 /*!
@@ -310,6 +327,69 @@ public:
  */
 	static OSPtr<const OSSymbol> withCStringNoCopy(const char * cString);
 
+
+/*!
+ * @function withCStrings
+ *
+ * @abstract
+ * Returns the OSSymbols for an array of C strings,
+ * creating those that do not already exist.
+ *
+ * @param cStrings  A C array of C strings to look up or copy.
+ * @param count     The number of strings in <code>cStrings</code>.
+ * @param symbols   A C array of at least <code>count</code> entries
+ *                  that receives the resulting symbols,
+ *                  in the same order as <code>cStrings</code>.
+ *
+ * @result
+ * <code>true</code> if every string was interned,
+ * <code>false</code> otherwise.
+ *
+ * @discussion
+ * This is equivalent to calling
+ * <code>@link withCString withCString@/link</code>
+ * on each string, but hashes and sorts the batch by shard first
+ * so that each shard is visited, and if needed locked, only once.
+ * It is intended for bulk loads such as unserializing plists.
+ *
+ * As with the other creators, each symbol is returned
+ * with an incremented retain count:
+ * with the raw pointer variant, the caller must release
+ * every entry of <code>symbols</code>;
+ * with the <code>OSSharedPtr</code> variant, each entry
+ * owns its reference.
+ * On failure, no symbols are returned
+ * and all entries of <code>symbols</code> are set to <code>NULL</code>.
+ */
+	static bool withCStrings(
+		const char * const        cStrings[],
+		unsigned int              count,
+		const OSSymbol *          symbols[]);
+
+	static bool withCStrings(
+		const char * const        cStrings[],
+		unsigned int              count,
+		OSSharedPtr<const OSSymbol> symbols[]);
+
+
+/*!
+ * @function getHash
+ *
+ * @abstract
+ * Returns the hash of the symbol's string value.
+ *
+ * @result
+ * The hash computed when the symbol was created.
+ *
+ * @discussion
+ * The value is stable for the lifetime of the symbol
+ * and is suitable for indexing hash tables keyed on symbols.
+ */
+	uint32_t getHash() const
+	{
+		return hashValue;
+	}
+
 /*!
  * @function existingSymbolForString
  *
@@ -71,6 +71,28 @@ int xts_decrypt(const uint8_t *ct, unsigned long ptlen,
     const uint8_t *tweak,                             // this can be considered the sector IV for this use
     symmetric_xts *xts);
 
+/*
+ * Batch interfaces: encrypt or decrypt count sectors of sector_len bytes
+ * each, in a single call.  The first sector uses tweak, and each following
+ * sector uses the previous tweak plus one (as a 128-bit little-endian
+ * integer), i.e. consecutive sector numbers.  Blocks are interleaved
+ * across the AES-NI pipeline when available.
+ */
+typedef struct {
+	const uint8_t *xs_in;
+	uint8_t       *xs_out;           // may be equal to xs_in
+} xts_sector_t;
+
+int xts_encrypt_sectors(const xts_sector_t *sectors, unsigned int count,
+    unsigned long sector_len,
+    const uint8_t *tweak,                             // tweak of the first sector
+    symmetric_xts *xts);
+
+int xts_decrypt_sectors(const xts_sector_t *sectors, unsigned int count,
+    unsigned long sector_len,
+    const uint8_t *tweak,                             // tweak of the first sector
+    symmetric_xts *xts);
+
 void xts_done(symmetric_xts *xts);
 
 #if defined(__cplusplus)
@@ -48,6 +48,21 @@ int     chacha20poly1305_finalize(chacha20poly1305_ctx *ctx, uint8_t *tag);
 int     chacha20poly1305_decrypt(chacha20poly1305_ctx *ctx, size_t nbytes, const void *ctext, void *ptext);
 int     chacha20poly1305_verify(chacha20poly1305_ctx *ctx, const uint8_t *tag);
 
+/*
+ * Scatter/gather variants of chacha20poly1305_encrypt/decrypt: process the
+ * segments in order as if they were one contiguous buffer, carrying the
+ * keystream and Poly1305 state across segment boundaries.  Segments may be
+ * of any length and may be processed in place (cv_out == cv_in).
+ */
+typedef struct {
+	const void      *cv_in;
+	void            *cv_out;
+	size_t          cv_len;
+} chacha20poly1305_iovec_t;
+
+int     chacha20poly1305_encrypt_iov(chacha20poly1305_ctx *ctx, const chacha20poly1305_iovec_t *iov, unsigned int iovcnt);
+int     chacha20poly1305_decrypt_iov(chacha20poly1305_ctx *ctx, const chacha20poly1305_iovec_t *iov, unsigned int iovcnt);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -62,6 +62,17 @@ void SHA256_Init(SHA256_CTX *ctx);
 void SHA256_Update(SHA256_CTX *ctx, const void *data, size_t len);
 void SHA256_Final(void *digest, SHA256_CTX *ctx);
 
+/*
+ * Multi-buffer SHA-256: computes the digests of count independent messages
+ * of the same length, interleaved 4 or 8 at a time in SIMD lanes when the
+ * CPU allows it, and one at a time otherwise.  digests[i] receives
+ * SHA256_DIGEST_LENGTH bytes for data[i].
+ */
+#define SHA256_MB_MAX_LANES     8
+
+void SHA256_MultiBuffer(const void * const data[], size_t len,
+    void * const digests[], unsigned int count);
+
 void SHA384_Init(SHA384_CTX *ctx);
 void SHA384_Update(SHA384_CTX *ctx, const void *data, size_t len);
 void SHA384_Final(void *digest, SHA384_CTX *ctx);
@@ -58,7 +58,7 @@
 
 /*
  * This file defines data structures for different types of trees:
- * splay trees and red-black trees.
+ * splay trees, red-black trees and B+-trees.
  *
  * A splay tree is a self-organizing data structure.  Every operation
  * on the tree causes a splay to happen.  The splay moves the requested
@@ -845,4 +845,513 @@ name##_RB_PREV(struct type *elm)                                        \
 	    ((x) != NULL) && ((y) = name##_RB_NEXT(x), (x) != NULL);    \
 	     (x) = (y))
 
+/*
+ * A B+-tree keeps elements in sorted order, like a red-black tree,
+ * but stores many keys per node: every node holds up to
+ * BT_NODE_NKEYS(keytype) keys packed in an array sized to a small
+ * number of cache lines, so that a lookup touches one or two lines per
+ * level and the tree is only a few levels deep even for millions of keys.
+ *
+ * Elements are not linked intrusively.  Leaves store (key, element)
+ * pairs and are chained to their neighbours, so ordered iteration and
+ * range scans walk the leaf chain without going back up the tree.
+ * Inner nodes only hold separator keys.  Nodes are allocated and freed
+ * with the allocfn/freefn functions given to BT_GENERATE(), and allocfn
+ * must not fail.
+ *
+ * The cmp function compares two keys (not elements) and returns a
+ * negative, zero or positive value like memcmp().  Keys are unique.
+ *
+ * Every operation on a B+-tree is bounded as O(log n), with a base
+ * of at least BT_NODE_NKEYS(keytype) / 2.
+ */
+
+#ifndef BT_NODE_KEY_BYTES
+#define BT_NODE_KEY_BYTES       128     /* two cache lines of keys */
+#endif
+
+#define BT_NODE_NKEYS(keytype)                                          \
+	(sizeof(keytype) * 4 > BT_NODE_KEY_BYTES ? 4 :                  \
+	BT_NODE_KEY_BYTES / sizeof(keytype))
+#define BT_NODE_MIN(keytype)    ((BT_NODE_NKEYS(keytype) - 1) / 2)
+
+#define BT_HEAD(name, type, keytype)                                    \
+struct name##_BT_NODE {                                                 \
+	uint16_t btn_count;     /* number of keys */                    \
+	uint16_t btn_leaf;      /* whether this node is a leaf */       \
+	struct name##_BT_NODE *btn_prev; /* previous leaf */            \
+	struct name##_BT_NODE *btn_next; /* next leaf */                \
+	keytype btn_keys[BT_NODE_NKEYS(keytype)];                       \
+	union {                                                         \
+	        struct name##_BT_NODE *btn_child[BT_NODE_NKEYS(keytype) + 1];\
+	        struct type *btn_elm[BT_NODE_NKEYS(keytype)];           \
+	};                                                              \
+};                                                                      \
+struct name##_BT_ITER {                                                 \
+	struct name##_BT_NODE *bti_node; /* current leaf */             \
+	unsigned int bti_idx;   /* index in the current leaf */         \
+};                                                                      \
+struct name {                                                           \
+	struct name##_BT_NODE *bth_root; /* root of the tree */         \
+	size_t bth_count;       /* number of elements */                \
+}
+
+#define BT_INITIALIZER(root)                                            \
+	{ NULL, 0 }
+
+#define BT_INIT(root) do {                                              \
+	(root)->bth_root = NULL;                                        \
+	(root)->bth_count = 0;                                          \
+} while ( /*CONSTCOND*/ 0)
+
+#define BT_ROOT(head)                   (head)->bth_root
+#define BT_EMPTY(head)                  (BT_ROOT(head) == NULL)
+#define BT_COUNT(head)                  (head)->bth_count
+#define BT_ITER(name)                   struct name##_BT_ITER
+#define BT_ITER_KEY(it)                 (it)->bti_node->btn_keys[(it)->bti_idx]
+
+#define BT_PROTOTYPE(name, type, keytype, cmp)                          \
+	BT_PROTOTYPE_SC(, name, type, keytype, cmp)
+
+/* Generates prototypes (with storage class) */
+#define BT_PROTOTYPE_SC(_sc_, name, type, keytype, cmp)                 \
+_sc_ struct type *name##_BT_INSERT(struct name *, keytype, struct type *); \
+_sc_ struct type *name##_BT_REMOVE(struct name *, keytype);             \
+_sc_ struct type *name##_BT_FIND(struct name *, keytype);               \
+_sc_ struct type *name##_BT_NFIND(struct name *, keytype, struct name##_BT_ITER *); \
+_sc_ struct type *name##_BT_PFIND(struct name *, keytype, struct name##_BT_ITER *); \
+_sc_ struct type *name##_BT_MINMAX(struct name *, struct name##_BT_ITER *, int); \
+_sc_ struct type *name##_BT_NEXT(struct name##_BT_ITER *);              \
+_sc_ struct type *name##_BT_PREV(struct name##_BT_ITER *);              \
+_sc_ int name##_BT_BEFORE(struct name##_BT_ITER *, keytype);            \
+_sc_ void name##_BT_DESTROY(struct name *)
+
+/* Main B+-tree operations.
+ * Nodes are split on the way down when inserting, and refilled on the
+ * way down when removing, so that no operation needs to walk back up.
+ */
+#define BT_GENERATE(name, type, keytype, cmp, allocfn, freefn)         \
+__attribute__((unused))                                                 \
+static struct name##_BT_NODE *                                          \
+name##_BT_NODE_ALLOC(int leaf)                                          \
+{                                                                       \
+	struct name##_BT_NODE *node;                                    \
+	node = (struct name##_BT_NODE *)allocfn(sizeof(*node));         \
+	node->btn_count = 0;                                            \
+	node->btn_leaf = (uint16_t)leaf;                                \
+	node->btn_prev = node->btn_next = NULL;                         \
+	return (node);                                                  \
+}                                                                       \
+                                                                        \
+/* Index of the first key in node that is >= key */                     \
+__attribute__((unused))                                                 \
+static unsigned int                                                     \
+name##_BT_LBOUND(struct name##_BT_NODE *node, keytype key)              \
+{                                                                       \
+	unsigned int i = 0;                                             \
+	while (i < node->btn_count && (cmp)(node->btn_keys[i], key) < 0) \
+	        i++;                                                    \
+	return (i);                                                     \
+}                                                                       \
+                                                                        \
+/* Index of the child of an inner node that covers key */               \
+__attribute__((unused))                                                 \
+static unsigned int                                                     \
+name##_BT_CHILDIDX(struct name##_BT_NODE *node, keytype key)            \
+{                                                                       \
+	unsigned int i = 0;                                             \
+	while (i < node->btn_count && (cmp)(node->btn_keys[i], key) <= 0) \
+	        i++;                                                    \
+	return (i);                                                     \
+}                                                                       \
+                                                                        \
+/* Splits the full child i of parent, which must not be full */         \
+__attribute__((unused))                                                 \
+static void                                                             \
+name##_BT_SPLIT(struct name##_BT_NODE *parent, unsigned int i)          \
+{                                                                       \
+	struct name##_BT_NODE *left = parent->btn_child[i];             \
+	struct name##_BT_NODE *right;                                   \
+	unsigned int mid = left->btn_count / 2, n, j;                   \
+	keytype sep;                                                    \
+	right = name##_BT_NODE_ALLOC(left->btn_leaf);                   \
+	if (left->btn_leaf) {                                           \
+	        n = left->btn_count - mid;                              \
+	        for (j = 0; j < n; j++) {                               \
+	                right->btn_keys[j] = left->btn_keys[mid + j];   \
+	                right->btn_elm[j] = left->btn_elm[mid + j];     \
+	        }                                                       \
+	        sep = right->btn_keys[0];                               \
+	        right->btn_next = left->btn_next;                       \
+	        right->btn_prev = left;                                 \
+	        if (left->btn_next != NULL)                             \
+	                left->btn_next->btn_prev = right;               \
+	        left->btn_next = right;                                 \
+	} else {                                                        \
+	        n = left->btn_count - mid - 1;                          \
+	        for (j = 0; j < n; j++)                                 \
+	                right->btn_keys[j] = left->btn_keys[mid + 1 + j]; \
+	        for (j = 0; j <= n; j++)                                \
+	                right->btn_child[j] = left->btn_child[mid + 1 + j]; \
+	        sep = left->btn_keys[mid];                              \
+	}                                                               \
+	right->btn_count = (uint16_t)n;                                 \
+	left->btn_count = (uint16_t)mid;                                \
+	for (j = parent->btn_count; j > i; j--) {                       \
+	        parent->btn_keys[j] = parent->btn_keys[j - 1];          \
+	        parent->btn_child[j + 1] = parent->btn_child[j];        \
+	}                                                               \
+	parent->btn_keys[i] = sep;                                      \
+	parent->btn_child[i + 1] = right;                               \
+	parent->btn_count++;                                            \
+}                                                                       \
+                                                                        \
+/* Inserts elm under key, returns the colliding element if any */       \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_INSERT(struct name *head, keytype key, struct type *elm)      \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	unsigned int i, j;                                              \
+	if (node == NULL) {                                             \
+	        node = head->bth_root = name##_BT_NODE_ALLOC(1);        \
+	} else if (node->btn_count == BT_NODE_NKEYS(keytype)) {         \
+	        head->bth_root = name##_BT_NODE_ALLOC(0);               \
+	        head->bth_root->btn_child[0] = node;                    \
+	        name##_BT_SPLIT(head->bth_root, 0);                     \
+	        node = head->bth_root;                                  \
+	}                                                               \
+	while (!node->btn_leaf) {                                       \
+	        i = name##_BT_CHILDIDX(node, key);                      \
+	        if (node->btn_child[i]->btn_count ==                    \
+	            BT_NODE_NKEYS(keytype)) {                           \
+	                name##_BT_SPLIT(node, i);                       \
+	                if ((cmp)(node->btn_keys[i], key) <= 0)         \
+	                        i++;                                    \
+	        }                                                       \
+	        node = node->btn_child[i];                              \
+	}                                                               \
+	i = name##_BT_LBOUND(node, key);                                \
+	if (i < node->btn_count && (cmp)(node->btn_keys[i], key) == 0)  \
+	        return (node->btn_elm[i]);                              \
+	for (j = node->btn_count; j > i; j--) {                         \
+	        node->btn_keys[j] = node->btn_keys[j - 1];              \
+	        node->btn_elm[j] = node->btn_elm[j - 1];                \
+	}                                                               \
+	node->btn_keys[i] = key;                                        \
+	node->btn_elm[i] = elm;                                         \
+	node->btn_count++;                                              \
+	head->bth_count++;                                              \
+	return (NULL);                                                  \
+}                                                                       \
+                                                                        \
+/*                                                                      \
+ * Makes sure child i of parent can lose a key, by borrowing from or    \
+ * merging with a sibling.  Returns the index of the child to descend   \
+ * into, which changes when the child is merged into its left sibling.  \
+ */                                                                     \
+__attribute__((unused))                                                 \
+static unsigned int                                                     \
+name##_BT_FILL(struct name *head, struct name##_BT_NODE *parent,        \
+    unsigned int i)                                                     \
+{                                                                       \
+	struct name##_BT_NODE *node = parent->btn_child[i];             \
+	struct name##_BT_NODE *sib, *left, *right;                      \
+	unsigned int j, n;                                              \
+	if (i > 0 && (sib = parent->btn_child[i - 1])->btn_count >      \
+	    BT_NODE_MIN(keytype)) {                                     \
+	        for (j = node->btn_count; j > 0; j--)                   \
+	                node->btn_keys[j] = node->btn_keys[j - 1];      \
+	        if (node->btn_leaf) {                                   \
+	                for (j = node->btn_count; j > 0; j--)           \
+	                        node->btn_elm[j] = node->btn_elm[j - 1]; \
+	                node->btn_keys[0] = sib->btn_keys[sib->btn_count - 1]; \
+	                node->btn_elm[0] = sib->btn_elm[sib->btn_count - 1]; \
+	                parent->btn_keys[i - 1] = node->btn_keys[0];    \
+	        } else {                                                \
+	                for (j = node->btn_count + 1; j > 0; j--)       \
+	                        node->btn_child[j] = node->btn_child[j - 1]; \
+	                node->btn_keys[0] = parent->btn_keys[i - 1];    \
+	                node->btn_child[0] = sib->btn_child[sib->btn_count]; \
+	                parent->btn_keys[i - 1] =                       \
+	                    sib->btn_keys[sib->btn_count - 1];          \
+	        }                                                       \
+	        sib->btn_count--;                                       \
+	        node->btn_count++;                                      \
+	        return (i);                                             \
+	}                                                               \
+	if (i < parent->btn_count &&                                    \
+	    (sib = parent->btn_child[i + 1])->btn_count >               \
+	    BT_NODE_MIN(keytype)) {                                     \
+	        if (node->btn_leaf) {                                   \
+	                node->btn_keys[node->btn_count] = sib->btn_keys[0]; \
+	                node->btn_elm[node->btn_count] = sib->btn_elm[0]; \
+	                for (j = 1; j < sib->btn_count; j++) {          \
+	                        sib->btn_keys[j - 1] = sib->btn_keys[j]; \
+	                        sib->btn_elm[j - 1] = sib->btn_elm[j];  \
+	                }                                               \
+	                parent->btn_keys[i] = sib->btn_keys[0];         \
+	        } else {                                                \
+	                node->btn_keys[node->btn_count] = parent->btn_keys[i]; \
+	                node->btn_child[node->btn_count + 1] =          \
+	                    sib->btn_child[0];                          \
+	                parent->btn_keys[i] = sib->btn_keys[0];         \
+	                for (j = 1; j < sib->btn_count; j++)            \
+	                        sib->btn_keys[j - 1] = sib->btn_keys[j]; \
+	                for (j = 1; j <= sib->btn_count; j++)           \
+	                        sib->btn_child[j - 1] = sib->btn_child[j]; \
+	        }                                                       \
+	        sib->btn_count--;                                       \
+	        node->btn_count++;                                      \
+	        return (i);                                             \
+	}                                                               \
+	if (i == parent->btn_count)                                     \
+	        i--;                                                    \
+	left = parent->btn_child[i];                                    \
+	right = parent->btn_child[i + 1];                               \
+	n = left->btn_count;                                            \
+	if (left->btn_leaf) {                                           \
+	        for (j = 0; j < right->btn_count; j++) {                \
+	                left->btn_keys[n + j] = right->btn_keys[j];     \
+	                left->btn_elm[n + j] = right->btn_elm[j];       \
+	        }                                                       \
+	        left->btn_count = (uint16_t)(n + right->btn_count);     \
+	        left->btn_next = right->btn_next;                       \
+	        if (right->btn_next != NULL)                            \
+	                right->btn_next->btn_prev = left;               \
+	} else {                                                        \
+	        left->btn_keys[n] = parent->btn_keys[i];                \
+	        for (j = 0; j < right->btn_count; j++)                  \
+	                left->btn_keys[n + 1 + j] = right->btn_keys[j]; \
+	        for (j = 0; j <= right->btn_count; j++)                 \
+	                left->btn_child[n + 1 + j] = right->btn_child[j]; \
+	        left->btn_count = (uint16_t)(n + 1 + right->btn_count); \
+	}                                                               \
+	freefn(right, sizeof(*right));                                  \
+	for (j = i + 1; j < parent->btn_count; j++) {                   \
+	        parent->btn_keys[j - 1] = parent->btn_keys[j];          \
+	        parent->btn_child[j] = parent->btn_child[j + 1];        \
+	}                                                               \
+	parent->btn_count--;                                            \
+	if (parent == head->bth_root && parent->btn_count == 0) {       \
+	        head->bth_root = left;                                  \
+	        freefn(parent, sizeof(*parent));                        \
+	}                                                               \
+	return (i);                                                     \
+}                                                                       \
+                                                                        \
+/* Removes the element stored under key and returns it */               \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_REMOVE(struct name *head, keytype key)                        \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	struct type *elm;                                               \
+	unsigned int i;                                                 \
+	if (node == NULL)                                               \
+	        return (NULL);                                          \
+	while (!node->btn_leaf) {                                       \
+	        i = name##_BT_CHILDIDX(node, key);                      \
+	        if (node->btn_child[i]->btn_count <= BT_NODE_MIN(keytype)) { \
+	                i = name##_BT_FILL(head, node, i);              \
+	                if (head->bth_root != node) {                   \
+	                        node = head->bth_root;                  \
+	                        continue;                               \
+	                }                                               \
+	                i = name##_BT_CHILDIDX(node, key);              \
+	        }                                                       \
+	        node = node->btn_child[i];                              \
+	}                                                               \
+	i = name##_BT_LBOUND(node, key);                                \
+	if (i == node->btn_count || (cmp)(node->btn_keys[i], key) != 0) \
+	        return (NULL);                                          \
+	elm = node->btn_elm[i];                                         \
+	for (node->btn_count--; i < node->btn_count; i++) {             \
+	        node->btn_keys[i] = node->btn_keys[i + 1];              \
+	        node->btn_elm[i] = node->btn_elm[i + 1];                \
+	}                                                               \
+	if (node == head->bth_root && node->btn_count == 0) {           \
+	        head->bth_root = NULL;                                  \
+	        freefn(node, sizeof(*node));                            \
+	}                                                               \
+	head->bth_count--;                                              \
+	return (elm);                                                   \
+}                                                                       \
+                                                                        \
+/* Finds the element stored under key */                                \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_FIND(struct name *head, keytype key)                          \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	unsigned int i;                                                 \
+	if (node == NULL)                                               \
+	        return (NULL);                                          \
+	while (!node->btn_leaf)                                         \
+	        node = node->btn_child[name##_BT_CHILDIDX(node, key)];  \
+	i = name##_BT_LBOUND(node, key);                                \
+	if (i < node->btn_count && (cmp)(node->btn_keys[i], key) == 0)  \
+	        return (node->btn_elm[i]);                              \
+	return (NULL);                                                  \
+}                                                                       \
+                                                                        \
+/* Finds the first element with a key greater than or equal to key */   \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_NFIND(struct name *head, keytype key, struct name##_BT_ITER *it) \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	unsigned int i;                                                 \
+	if (node == NULL)                                               \
+	        return (NULL);                                          \
+	while (!node->btn_leaf)                                         \
+	        node = node->btn_child[name##_BT_CHILDIDX(node, key)];  \
+	i = name##_BT_LBOUND(node, key);                                \
+	if (i == node->btn_count) {                                     \
+	        node = node->btn_next;                                  \
+	        i = 0;                                                  \
+	        if (node == NULL)                                       \
+	                return (NULL);                                  \
+	}                                                               \
+	if (it != NULL) {                                               \
+	        it->bti_node = node;                                    \
+	        it->bti_idx = i;                                        \
+	}                                                               \
+	return (node->btn_elm[i]);                                      \
+}                                                                       \
+                                                                        \
+/* Finds the last element with a key less than or equal to key */       \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_PFIND(struct name *head, keytype key, struct name##_BT_ITER *it) \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	unsigned int i;                                                 \
+	if (node == NULL)                                               \
+	        return (NULL);                                          \
+	while (!node->btn_leaf)                                         \
+	        node = node->btn_child[name##_BT_CHILDIDX(node, key)];  \
+	i = name##_BT_LBOUND(node, key);                                \
+	if (i == node->btn_count || (cmp)(node->btn_keys[i], key) != 0) { \
+	        if (i == 0) {                                           \
+	                node = node->btn_prev;                          \
+	                if (node == NULL)                               \
+	                        return (NULL);                          \
+	                i = node->btn_count;                            \
+	        }                                                       \
+	        i--;                                                    \
+	}                                                               \
+	if (it != NULL) {                                               \
+	        it->bti_node = node;                                    \
+	        it->bti_idx = i;                                        \
+	}                                                               \
+	return (node->btn_elm[i]);                                      \
+}                                                                       \
+                                                                        \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_MINMAX(struct name *head, struct name##_BT_ITER *it, int val) \
+{                                                                       \
+	struct name##_BT_NODE *node = head->bth_root;                   \
+	unsigned int i;                                                 \
+	if (node == NULL)                                               \
+	        return (NULL);                                          \
+	while (!node->btn_leaf)                                         \
+	        node = node->btn_child[val < 0 ? 0 : node->btn_count];  \
+	i = val < 0 ? 0 : node->btn_count - 1u;                         \
+	if (it != NULL) {                                               \
+	        it->bti_node = node;                                    \
+	        it->bti_idx = i;                                        \
+	}                                                               \
+	return (node->btn_elm[i]);                                      \
+}                                                                       \
+                                                                        \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_NEXT(struct name##_BT_ITER *it)                               \
+{                                                                       \
+	if (++it->bti_idx == it->bti_node->btn_count) {                 \
+	        it->bti_node = it->bti_node->btn_next;                  \
+	        it->bti_idx = 0;                                        \
+	        if (it->bti_node == NULL)                               \
+	                return (NULL);                                  \
+	}                                                               \
+	return (it->bti_node->btn_elm[it->bti_idx]);                    \
+}                                                                       \
+                                                                        \
+__attribute__((unused))                                                 \
+struct type *                                                           \
+name##_BT_PREV(struct name##_BT_ITER *it)                               \
+{                                                                       \
+	if (it->bti_idx == 0) {                                         \
+	        it->bti_node = it->bti_node->btn_prev;                  \
+	        if (it->bti_node == NULL)                               \
+	                return (NULL);                                  \
+	        it->bti_idx = it->bti_node->btn_count;                  \
+	}                                                               \
+	it->bti_idx--;                                                  \
+	return (it->bti_node->btn_elm[it->bti_idx]);                    \
+}                                                                       \
+                                                                        \
+/* Returns whether the key at the iterator is below limit */            \
+__attribute__((unused))                                                 \
+int                                                                     \
+name##_BT_BEFORE(struct name##_BT_ITER *it, keytype limit)              \
+{                                                                       \
+	return ((cmp)(BT_ITER_KEY(it), limit) < 0);                     \
+}                                                                       \
+                                                                        \
+__attribute__((unused))                                                 \
+static void                                                             \
+name##_BT_DESTROY_NODE(struct name##_BT_NODE *node)                     \
+{                                                                       \
+	unsigned int i;                                                 \
+	if (!node->btn_leaf) {                                          \
+	        for (i = 0; i <= node->btn_count; i++)                  \
+	                name##_BT_DESTROY_NODE(node->btn_child[i]);     \
+	}                                                               \
+	freefn(node, sizeof(*node));                                    \
+}                                                                       \
+                                                                        \
+/* Frees all nodes, the elements themselves are left untouched */       \
+__attribute__((unused))                                                 \
+void                                                                    \
+name##_BT_DESTROY(struct name *head)                                    \
+{                                                                       \
+	if (head->bth_root != NULL)                                     \
+	        name##_BT_DESTROY_NODE(head->bth_root);                 \
+	head->bth_root = NULL;                                          \
+	head->bth_count = 0;                                            \
+}
+
+#define BT_NEGINF       -1
+#define BT_INF  1
+
+#define BT_INSERT(name, x, k, y)        name##_BT_INSERT(x, k, y)
+#define BT_REMOVE(name, x, k)           name##_BT_REMOVE(x, k)
+#define BT_FIND(name, x, k)             name##_BT_FIND(x, k)
+#define BT_NFIND(name, x, k, it)        name##_BT_NFIND(x, k, it)
+#define BT_PFIND(name, x, k, it)        name##_BT_PFIND(x, k, it)
+#define BT_NEXT(name, it)               name##_BT_NEXT(it)
+#define BT_PREV(name, it)               name##_BT_PREV(it)
+#define BT_MIN(name, x, it)             name##_BT_MINMAX(x, it, BT_NEGINF)
+#define BT_MAX(name, x, it)             name##_BT_MINMAX(x, it, BT_INF)
+#define BT_DESTROY(name, x)             name##_BT_DESTROY(x)
+
+#define BT_FOREACH(x, name, head, it)                                   \
+	for ((x) = BT_MIN(name, head, it);                              \
+	     (x) != NULL;                                               \
+	     (x) = name##_BT_NEXT(it))
+
+#define BT_FOREACH_REVERSE(x, name, head, it)                           \
+	for ((x) = BT_MAX(name, head, it);                              \
+	     (x) != NULL;                                               \
+	     (x) = name##_BT_PREV(it))
+
+/* Visits the elements with keys in [lo, hi) in order */
+#define BT_FOREACH_RANGE(x, name, head, it, lo, hi)                     \
+	for ((x) = BT_NFIND(name, head, lo, it);                        \
+	     (x) != NULL && name##_BT_BEFORE(it, hi);                   \
+	     (x) = name##_BT_NEXT(it))
+
 #endif  /* _LIBKERN_TREE_H_ */
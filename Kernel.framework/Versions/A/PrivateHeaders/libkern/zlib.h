@@ -1074,6 +1074,33 @@ ZEXTERN uLong ZEXPORT compressBound OF((uLong sourceLen));
  *  a compress() or compress2() call to allocate the destination buffer.
  */
 
+ZEXTERN int ZEXPORT compress_parallel OF((Bytef * dest, uLongf *destLen,
+    const Bytef *source, uLong sourceLen,
+    int level, uLong blockSize, uInt threads));
+/*
+ *    Same as compress2(), but splits the source buffer into blocks of
+ *  blockSize bytes that are deflated independently by up to threads worker
+ *  threads.  Each block is primed with the last 32K of the previous block
+ *  as a preset dictionary and ends with a sync flush, so that the blocks
+ *  can be concatenated into a single valid zlib stream, whose Adler-32 is
+ *  obtained with adler32_combine() over the blocks.  The output is slightly
+ *  larger than with compress2(); destLen must be at least the value
+ *  returned by compressBound_parallel(sourceLen, blockSize).
+ *    A blockSize of 0 selects a default (128K), and threads equal to 0 or
+ *  1 compresses the blocks on the calling thread.
+ *
+ *    compress_parallel returns Z_OK if success, Z_MEM_ERROR if there was not
+ *  enough memory, Z_BUF_ERROR if there was not enough room in the output
+ *  buffer, Z_STREAM_ERROR if a parameter is invalid.
+ */
+
+ZEXTERN uLong ZEXPORT compressBound_parallel OF((uLong sourceLen,
+    uLong blockSize));
+/*
+ *    compressBound_parallel() returns an upper bound on the compressed size
+ *  after compress_parallel() on sourceLen bytes with the given blockSize.
+ */
+
 ZEXTERN int ZEXPORT uncompress OF((Bytef * dest, uLongf *destLen,
     const Bytef *source, uLong sourceLen));
 /*
@@ -232,6 +232,8 @@ struct bpf_version {
 #define BIOCSETUP       _IOW('B', 131, struct bpf_setup_args)
 #define BIOCSPKTHDRV2   _IOW('B', 132, int)
 #define BIOCGPKTHDRV2   _IOW('B', 133, int)
+#define BIOCSRING       _IOW('B', 134, struct bpf_ring_req)
+#define BIOCGRING       _IOR('B', 135, struct bpf_ring_req)
 /*
  * Structure prepended to each packet.
  */
@@ -275,6 +277,54 @@ struct bpf_hdr_ext {
 	bpf_u_int32     bh_unsent_snd; /* unsent bytes at socket buffer */
 };
 
+/*
+ * Memory-mapped capture ring.
+ *
+ * BIOCSRING switches a bpf device (before BIOCSETIF) from read() double
+ * buffering to a ring of br_block_count blocks of br_block_size bytes,
+ * which the reader then maps with mmap(2) on the device.  Each block
+ * starts with a struct bpf_ring_block_hdr.  The kernel fills the blocks
+ * it owns with bpf_hdr_ext framed packets, each starting at the
+ * BPF_WORDALIGN() of the end of the previous one, and hands a block over
+ * to the reader by setting bb_status to BPF_RING_BLOCK_USER when it is
+ * full or br_block_timeout ms after its first packet.  The reader gives
+ * the block back by resetting bb_status to BPF_RING_BLOCK_KERNEL.
+ *
+ * bb_status is the only synchronization between the kernel and the reader,
+ * and must be accessed with BPF_RING_STATUS_LOAD() and
+ * BPF_RING_STATUS_STORE(): each side stores the new owner with release
+ * semantics once it is done with the block (the kernel after writing the
+ * packets and the rest of the header, the reader after its last access to
+ * the block), and loads it with acquire semantics before touching the
+ * block, so that the other side's accesses are ordered before its own.
+ * Packets that arrive when no block is available are counted in bb_drops
+ * of the next block and in bs_drop.  read() fails with EINVAL in ring mode.
+ */
+struct bpf_ring_req {
+	bpf_u_int32     br_block_size;  /* multiple of the page size */
+	bpf_u_int32     br_block_count;
+	bpf_u_int32     br_block_timeout; /* in milliseconds, 0 for default */
+	bpf_u_int32     br_flags;       /* must be 0 */
+};
+
+#define BPF_RING_BLOCK_KERNEL   0
+#define BPF_RING_BLOCK_USER     1
+
+#define BPF_RING_STATUS_LOAD(bb) \
+	__atomic_load_n(&(bb)->bb_status, __ATOMIC_ACQUIRE)
+#define BPF_RING_STATUS_STORE(bb, status) \
+	__atomic_store_n(&(bb)->bb_status, (status), __ATOMIC_RELEASE)
+
+struct bpf_ring_block_hdr {
+	volatile bpf_u_int32 bb_status; /* BPF_RING_BLOCK_KERNEL or _USER */
+	bpf_u_int32     bb_num_pkts;    /* number of packets in the block */
+	bpf_u_int32     bb_first_offset; /* offset of the first bpf_hdr_ext */
+	bpf_u_int32     bb_len;         /* bytes used, including this header */
+	u_int64_t       bb_seq;         /* block sequence number */
+	bpf_u_int32     bb_drops;       /* packets dropped before this block */
+	bpf_u_int32     _bb_pad;
+};
+
 #define BPF_CONTROL_NAME        "com.apple.net.bpf"
 
 struct bpf_mtag {
@@ -1344,6 +1394,39 @@ extern void     bpfdetach(struct ifnet *);
 extern void     bpfilterattach(int);
 extern u_int    bpf_filter(const struct bpf_insn *, u_char *, u_int, u_int);
 
+/*
+ * bpf_filter_mbuf() runs a program over a packet held in an mbuf chain,
+ * whose first wirelen bytes make up the packet, resolving BPF_LD loads
+ * that fall in or straddle later mbufs by walking the chain instead of
+ * copying it out.
+ *
+ * bpf_filter_vector() runs a program over npkts such packets and sets bit
+ * i of the match bitmap (npkts bits, as in kern/bits.h) when packet i is
+ * accepted.  If snaplens is not NULL, it receives each filter result.
+ * Returns the number of accepted packets.
+ */
+extern u_int    bpf_filter_mbuf(const struct bpf_insn *, struct mbuf *, u_int wirelen);
+extern u_int    bpf_filter_vector(const struct bpf_insn *, struct mbuf * const *pkts,
+    const u_int *wirelens, u_int npkts, uint64_t *match, u_int *snaplens);
+
+/*
+ * Native code (x86_64) for a filter program, compiled once the program
+ * has passed bpf_validate() at BIOCSETF/BIOCSETFNR time.  bpf_jitter()
+ * returns NULL if the program cannot be compiled or the JIT is disabled
+ * (net.bpf.jitter), in which case bpf_filter() keeps interpreting it;
+ * the compiled function returns the same value as bpf_filter() would.
+ */
+typedef u_int   (*bpf_filter_func)(u_char *, u_int, u_int);
+
+typedef struct bpf_jit_filter {
+	bpf_filter_func func;           /* compiled code */
+	size_t          size;           /* size of the code buffer */
+} bpf_jit_filter;
+
+extern int              bpf_jitter_enable;
+extern bpf_jit_filter   *bpf_jitter(const struct bpf_insn *, int);
+extern void             bpf_destroy_jit_filter(bpf_jit_filter *);
+
 #ifndef BPF_TAP_MODE_T
 #define BPF_TAP_MODE_T
 /*!
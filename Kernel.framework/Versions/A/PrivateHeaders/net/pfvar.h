@@ -931,7 +931,7 @@ struct pf_app_state {
 	} u;
 };
 
-/* keep synced with struct pf_state, used in RB_FIND */
+/* keep synced with struct pf_state_key, used in pf_state_table_find() */
 struct pf_state_key_cmp {
 	struct pf_state_host lan;
 	struct pf_state_host gwy;
@@ -961,8 +961,8 @@ struct pf_state_key {
 	u_int32_t        flowsrc;
 	u_int32_t        flowhash;
 
-	RB_ENTRY(pf_state_key)   entry_lan_ext;
-	RB_ENTRY(pf_state_key)   entry_ext_gwy;
+	struct pf_state_key *_Atomic hash_next_lan_ext; /* same hashed fields */
+	struct pf_state_key *_Atomic hash_next_ext_gwy;
 	struct pf_statelist      states;
 	u_int32_t        refcnt;
 };
@@ -1011,6 +1011,8 @@ struct pf_state {
 	u_int64_t                creation;
 	u_int64_t                expire;
 	u_int64_t                pfsync_time;
+	TAILQ_ENTRY(pf_state)    entry_expire;  /* expiry wheel slot */
+	u_int32_t                expire_slot;
 	u_int16_t                tag;
 	u_int8_t                 log;
 	u_int8_t                 allow_opts;
@@ -1291,19 +1293,82 @@ struct pfr_ktable {
 #define pfrkt_nomatch   pfrkt_ts.pfrts_nomatch
 #define pfrkt_tzero     pfrkt_ts.pfrts_tzero
 
-RB_HEAD(pf_state_tree_lan_ext, pf_state_key);
-RB_PROTOTYPE_SC(__private_extern__, pf_state_tree_lan_ext, pf_state_key,
-    entry_lan_ext, pf_state_compare_lan_ext);
+/*
+ * State key tables, one per lookup direction (lan/ext and ext/gwy).
+ *
+ * Bucketized cuckoo hash: a key lives in one of two buckets picked from its
+ * hash, and each bucket holds PF_STATE_BUCKET_SLOTS slots and their 16-bit
+ * hash tags in one cache line.  Keys whose hashed fields are all equal
+ * share a slot, chained through hash_next_lan_ext/hash_next_ext_gwy.
+ * When both buckets of a new key are full, keys are displaced to their
+ * alternate bucket, and the table is doubled if that fails.  Like
+ * RB_INSERT, pf_state_table_insert() returns NULL on success, or the
+ * colliding key already in the table.
+ *
+ * pst_hash must agree with pst_cmp: keys that pf_state_compare_lan_ext()
+ * or pf_state_compare_ext_gwy() consider equal must hash to the same
+ * value.  Like the comparators, it covers proto_variant and branches on
+ * it for UDP keys: the ext port is hashed only when proto_variant is below
+ * PF_EXTFILTER_AD, and the ext address only when it is below
+ * PF_EXTFILTER_EI.  The hash leaves out just the fields the comparators
+ * skip for that variant and the protocol specific fields they defer to
+ * the app_state compare callback, so states that differ only in a
+ * compared ext endpoint do not pile up in one slot's chain.
+ *
+ * Concurrency: insertions, removals, displacements and resizes are
+ * serialized by pf_lock; lookups take no lock.
+ *  - A table generation (buckets and mask) is published as a whole through
+ *    pst_gen with release semantics, and readers load it once per lookup
+ *    with acquire semantics, so a mask is never paired with the buckets of
+ *    another generation.  Old generations are freed after a grace period.
+ *  - Writers make psb_seq odd (relaxed store followed by a release fence)
+ *    before editing a bucket and store the next even value with release
+ *    semantics after; readers load psb_seq with acquire semantics, retry
+ *    while it is odd, read the tags, slots and chains with relaxed atomic
+ *    loads, then issue an acquire fence and retry if psb_seq changed.
+ *  - Keys are freed only after a grace period, so a reader racing with a
+ *    removal never dereferences freed memory.
+ */
+#define PF_STATE_BUCKET_SLOTS   6
+
+struct pf_state_bucket {
+	_Atomic u_int32_t                psb_seq;
+	_Atomic u_int16_t                psb_tags[PF_STATE_BUCKET_SLOTS];
+	struct pf_state_key *_Atomic     psb_keys[PF_STATE_BUCKET_SLOTS];
+} __attribute__((aligned(64)));
+
+struct pf_state_table_gen {
+	u_int32_t                psg_mask;      /* number of buckets - 1 */
+	u_int32_t                psg_seed;
+	struct pf_state_bucket   psg_buckets[];
+};
 
-RB_HEAD(pf_state_tree_ext_gwy, pf_state_key);
-RB_PROTOTYPE_SC(__private_extern__, pf_state_tree_ext_gwy, pf_state_key,
-    entry_ext_gwy, pf_state_compare_ext_gwy);
+struct pf_state_table {
+	struct pf_state_table_gen *_Atomic pst_gen;
+	u_int32_t                pst_count;
+	u_int32_t                (*pst_hash)(const struct pf_state_key_cmp *, u_int32_t);
+	int                      (*pst_cmp)(struct pf_state_key *, struct pf_state_key *);
+};
 
 RB_HEAD(pfi_ifhead, pfi_kif);
 
 /* state tables */
-extern struct pf_state_tree_lan_ext      pf_statetbl_lan_ext;
-extern struct pf_state_tree_ext_gwy      pf_statetbl_ext_gwy;
+extern struct pf_state_table    pf_statetbl_lan_ext;
+extern struct pf_state_table    pf_statetbl_ext_gwy;
+
+__private_extern__ int pf_state_compare_lan_ext(struct pf_state_key *,
+    struct pf_state_key *);
+__private_extern__ int pf_state_compare_ext_gwy(struct pf_state_key *,
+    struct pf_state_key *);
+__private_extern__ int pf_state_table_init(struct pf_state_table *,
+    u_int32_t, u_int32_t (*)(const struct pf_state_key_cmp *, u_int32_t),
+    int (*)(struct pf_state_key *, struct pf_state_key *));
+__private_extern__ struct pf_state_key *pf_state_table_find(
+	struct pf_state_table *, struct pf_state_key_cmp *);
+__private_extern__ struct pf_state_key *pf_state_table_insert(
+	struct pf_state_table *, struct pf_state_key *);
+__private_extern__ void pf_state_table_remove(struct pf_state_table *,
+    struct pf_state_key *);
 
 struct pfi_kif {
 	char                             pfik_name[IFNAMSIZ];
@@ -2174,6 +2239,17 @@ __private_extern__ int pf_normalize_tcp_stateful(pbuf_t *, int,
     struct pf_pdesc *, u_short *, struct tcphdr *, struct pf_state *,
     struct pf_state_peer *, struct pf_state_peer *, int *);
 __private_extern__ u_int64_t pf_state_expires(const struct pf_state *);
+
+/*
+ * States are filed in a timer wheel of PF_EXPIRE_WHEEL_SLOTS one-second
+ * slots by pf_state_expires(), so that pf_purge_expired_states() only
+ * visits the slots that came due instead of scanning state_list.  States
+ * that expire beyond the wheel are refiled when their slot comes around.
+ */
+#define PF_EXPIRE_WHEEL_SLOTS   1024
+
+__private_extern__ void pf_state_expire_schedule(struct pf_state *);
+__private_extern__ void pf_state_expire_cancel(struct pf_state *);
 __private_extern__ void pf_purge_expired_fragments(void);
 __private_extern__ int pf_routable(struct pf_addr *addr, sa_family_t af,
     struct pfi_kif *);
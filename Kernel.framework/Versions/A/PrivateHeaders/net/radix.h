@@ -187,8 +187,37 @@ struct radix_node_head {
 	(struct radix_node *rn, struct radix_node_head *head);
 	struct  radix_node rnh_nodes[3];        /* empty tree for common case */
 	int     rnh_cnt;                        /* tree dimension */
+	struct  rn_fib *rnh_fib;                /* compressed trie, if any */
 };
 
+/*
+ * Read-optimized longest-prefix-match index (poptrie style) kept alongside
+ * the radix tree: a direct-indexed first level resolves the first
+ * RN_FIB_STRIDE0 bits of the key, and each further level resolves
+ * RN_FIB_STRIDE bits through popcount-compressed child and leaf arrays,
+ * so that a lookup costs a few dependent loads instead of a bit-by-bit
+ * walk and mask chain scan.  Leaves point back to the radix leaves.
+ *
+ * rn_fib_attach() builds the index for a head whose keys are sockaddrs
+ * holding keybits-bit addresses (32 for AF_INET, 128 for AF_INET6).
+ * After rn_addroute()/rn_delete(), rn_fib_update() rebuilds the part of
+ * the index covered by the changed prefix, given the key and netmask
+ * sockaddrs of that route, and publishes it atomically.
+ *
+ * rn_fib_match() returns the same leaf as rn_match(), falling back to it
+ * when the head has no index.  rn_fib_match_args() serves lookups with a
+ * rn_matchf_t, such as the interface scoped IPv4/IPv6 route lookups: it
+ * applies the callback to the longest matching leaf found through the
+ * index and to its duplicated keys, and only falls back to
+ * rn_match_args(), which backtracks over shorter prefixes, when none of
+ * them is accepted.  Scoped lookups whose longest match is in scope, the
+ * common case, thus also take the fast path.
+ */
+#define RN_FIB_STRIDE0  16
+#define RN_FIB_STRIDE   6
+
+struct rn_fib;
+
 #define Bcmp(a, b, n) bcmp(((caddr_t)(a)), ((caddr_t)(b)), (unsigned)(n))
 #define Bcopy(a, b, n) bcopy(((caddr_t)(a)), ((caddr_t)(b)), (unsigned)(n))
 #define Bzero(p, n) bzero((caddr_t)(p), (unsigned)(n));
@@ -209,4 +238,11 @@ struct radix_node
 *rn_match(void *, struct radix_node_head *),
 *rn_match_args(void *, struct radix_node_head *, rn_matchf_t *, void *);
 
+int      rn_fib_attach(struct radix_node_head *head, int keybits);
+void     rn_fib_detach(struct radix_node_head *head);
+void     rn_fib_update(struct radix_node_head *head, void *key, void *mask);
+struct radix_node
+*rn_fib_match(void *, struct radix_node_head *),
+*rn_fib_match_args(void *, struct radix_node_head *, rn_matchf_t *, void *);
+
 #endif /* _RADIX_H_ */
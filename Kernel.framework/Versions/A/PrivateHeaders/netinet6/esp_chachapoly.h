@@ -28,3 +28,22 @@
 
 #include <sys/appleapiopts.h>
 
+
+#ifndef _ESP_CHACHA_POLY_H_
+#define _ESP_CHACHA_POLY_H_
+
+#include <sys/kpi_mbuf.h>
+#include <libkern/crypto/chacha20poly1305.h>
+
+/*
+ * Encrypts (or decrypts) len bytes of the mbuf chain m in place, starting
+ * at offset off, without linearizing it: the fragments are walked with
+ * mbuf_data()/mbuf_len() and handed to chacha20poly1305_{en,de}crypt_iov()
+ * in batches.
+ */
+#define ESP_CHACHAPOLY_IOV_BATCH        16
+
+errno_t esp_chachapoly_encrypt_mbuf(chacha20poly1305_ctx *ctx, mbuf_t m, size_t off, size_t len);
+errno_t esp_chachapoly_decrypt_mbuf(chacha20poly1305_ctx *ctx, mbuf_t m, size_t off, size_t len);
+
+#endif /* _ESP_CHACHA_POLY_H_ */
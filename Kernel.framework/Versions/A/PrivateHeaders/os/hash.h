@@ -101,6 +101,215 @@ os_hash_kernel_pointer(const void *pointer)
 	return (uint32_t)key ^ __builtin_bswap32((uint32_t)key);
 }
 
+/*!
+ * @const OS_HASH_PRIME*
+ *
+ * @brief
+ * Multiplicative constants used by the block-wise hashes below.
+ */
+#define OS_HASH_PRIME1  0x9e3779b185ebca87ull
+#define OS_HASH_PRIME2  0xc2b2ae3d27d4eb4full
+#define OS_HASH_PRIME3  0x165667b19e3779f9ull
+#define OS_HASH_PRIME4  0x85ebca77c2b2ae63ull
+#define OS_HASH_PRIME5  0x27d4eb2f165667c5ull
+
+static inline uint64_t
+os_hash_rotl64(uint64_t x, unsigned r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+os_hash_load64(const uint8_t *p)
+{
+	uint64_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t
+os_hash_load32(const uint8_t *p)
+{
+	uint32_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t
+os_hash_round(uint64_t acc, uint64_t input)
+{
+	acc += input * OS_HASH_PRIME2;
+	acc = os_hash_rotl64(acc, 31);
+	return acc * OS_HASH_PRIME1;
+}
+
+static inline uint64_t
+os_hash_merge(uint64_t acc, uint64_t lane)
+{
+	acc ^= os_hash_round(0, lane);
+	return acc * OS_HASH_PRIME1 + OS_HASH_PRIME4;
+}
+
+/*!
+ * @function os_hash_words_seeded
+ *
+ * @brief
+ * A seeded word-at-a-time hash (the xxHash64 construction).
+ *
+ * @discussion
+ * Input is consumed in 32 byte stripes by four independent 64-bit lanes,
+ * which have no data dependency on one another and can be kept in
+ * separate registers, or in the lanes of a single vector register.
+ * The tail is folded in 8, 4 and then 1 byte at a time.
+ *
+ * Words are read in host (little endian) byte order with unaligned loads,
+ * so @a data need not be aligned.
+ *
+ * The result is identical to XXH64(data, length, seed).
+ * Use os_hash_words_seeded() with a per-table random seed for tables
+ * whose keys can be influenced by userspace.
+ *
+ * @param data
+ * The address of the data to hash.
+ *
+ * @param length
+ * The length of the data to hash
+ *
+ * @param seed
+ * The seed to start hashing from.
+ *
+ * @returns
+ * The 64-bit hash for this data.
+ */
+static inline uint64_t
+os_hash_words_seeded(const void *data, size_t length, uint64_t seed)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	const uint8_t *end = p + length;
+	uint64_t hash;
+
+	if (length >= 32) {
+		const uint8_t *limit = end - 32;
+		uint64_t v1 = seed + OS_HASH_PRIME1 + OS_HASH_PRIME2;
+		uint64_t v2 = seed + OS_HASH_PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - OS_HASH_PRIME1;
+
+		do {
+			v1 = os_hash_round(v1, os_hash_load64(p));
+			v2 = os_hash_round(v2, os_hash_load64(p + 8));
+			v3 = os_hash_round(v3, os_hash_load64(p + 16));
+			v4 = os_hash_round(v4, os_hash_load64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = os_hash_rotl64(v1, 1) + os_hash_rotl64(v2, 7) +
+		    os_hash_rotl64(v3, 12) + os_hash_rotl64(v4, 18);
+		hash = os_hash_merge(hash, v1);
+		hash = os_hash_merge(hash, v2);
+		hash = os_hash_merge(hash, v3);
+		hash = os_hash_merge(hash, v4);
+	} else {
+		hash = seed + OS_HASH_PRIME5;
+	}
+
+	hash += (uint64_t)length;
+
+	for (; p + 8 <= end; p += 8) {
+		hash ^= os_hash_round(0, os_hash_load64(p));
+		hash = os_hash_rotl64(hash, 27) * OS_HASH_PRIME1 + OS_HASH_PRIME4;
+	}
+
+	if (p + 4 <= end) {
+		hash ^= (uint64_t)os_hash_load32(p) * OS_HASH_PRIME1;
+		hash = os_hash_rotl64(hash, 23) * OS_HASH_PRIME2 + OS_HASH_PRIME3;
+		p += 4;
+	}
+
+	for (; p < end; p++) {
+		hash ^= (*p) * OS_HASH_PRIME5;
+		hash = os_hash_rotl64(hash, 11) * OS_HASH_PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= OS_HASH_PRIME2;
+	hash ^= hash >> 29;
+	hash *= OS_HASH_PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+/*!
+ * @function os_hash_words
+ *
+ * @brief
+ * A fast word-at-a-time hash for long keys.
+ *
+ * @discussion
+ * This is os_hash_words_seeded() with a zero seed,
+ * folded to 32 bits so that it can be used in place of os_hash_jenkins().
+ * It is not bit-compatible with os_hash_jenkins(),
+ * which remains the reference hash for existing tables.
+ *
+ * @param data
+ * The address of the data to hash.
+ *
+ * @param length
+ * The length of the data to hash
+ *
+ * @returns
+ * The hash for this data.
+ */
+static inline uint32_t
+os_hash_words(const void *data, size_t length)
+{
+	uint64_t hash = os_hash_words_seeded(data, length, 0);
+	return (uint32_t)hash ^ (uint32_t)(hash >> 32);
+}
+
+/*!
+ * @function os_hash_words_batch
+ *
+ * @brief
+ * Hashes several keys with os_hash_words_seeded() in one call.
+ *
+ * @discussion
+ * Keys are hashed two at a time so that the multiply chains of
+ * neighbouring keys can overlap in the pipeline.
+ *
+ * @param keys
+ * An array of @a count key addresses.
+ *
+ * @param lengths
+ * An array of @a count key lengths.
+ *
+ * @param seed
+ * The seed to start hashing each key from.
+ *
+ * @param hashes
+ * An array of @a count entries that receives the hash of each key.
+ *
+ * @param count
+ * The number of keys to hash.
+ */
+static inline void
+os_hash_words_batch(const void *const *keys, const size_t *lengths,
+    uint64_t seed, uint64_t *hashes, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 2 <= count; i += 2) {
+		uint64_t h0 = os_hash_words_seeded(keys[i], lengths[i], seed);
+		uint64_t h1 = os_hash_words_seeded(keys[i + 1], lengths[i + 1], seed);
+		hashes[i] = h0;
+		hashes[i + 1] = h1;
+	}
+	if (i < count) {
+		hashes[i] = os_hash_words_seeded(keys[i], lengths[i], seed);
+	}
+}
+
 __END_DECLS
 
 #endif // _OS_HASH_H_
@@ -145,6 +145,52 @@ static os_ref_count_t os_ref_release_locked(struct os_refcnt *) OS_WARN_RESULT;
  */
 static os_ref_count_t os_ref_get_count(struct os_refcnt *rc);
 
+/*
+ * os_pcpu_ref: per-CPU sharded reference counts
+ *
+ * A sharded refcount is meant for hot objects shared by every core, such as
+ * credentials or interfaces, whose single counter cache line would otherwise
+ * bounce between CPUs. While the object is live, retain and release only
+ * update a counter private to the current CPU, and the object cannot be freed.
+ *
+ * Teardown starts with os_pcpu_ref_kill(), which drops the reference taken
+ * at init time and collapses the per-CPU counters into a single atomic count.
+ * From then on the refcount behaves exactly like an os_refcnt: releases are
+ * atomic, the release that brings the count to zero returns 0, and
+ * os_pcpu_ref_retain_try() fails once the count reached zero.
+ *
+ * os_pcpu_ref_init: allocate the per-CPU counters and set the count to 1.
+ *		Returns false if the counters could not be allocated.
+ *
+ * os_pcpu_ref_kill: start teardown by releasing the initial reference, and
+ *		return the new collapsed count. 0 means this was the last reference.
+ *		Must be called exactly once, and may block. The atomic count is
+ *		biased by OS_PCPU_REF_BIAS until the per-CPU counters have been
+ *		folded into it, so that concurrent releases cannot see it reach
+ *		zero early (see refcnt_internal.h).
+ *
+ * os_pcpu_ref_destroy: free the per-CPU counters, once the count reached 0.
+ *
+ * os_pcpu_ref_retain / os_pcpu_ref_retain_try / os_pcpu_ref_release /
+ * os_pcpu_ref_release_live: as for os_refcnt. While the refcount is live,
+ *		os_pcpu_ref_release() returns OS_PCPU_REF_LIVE rather than the
+ *		(unknown) total count.
+ *
+ * os_pcpu_ref_get_count: return the current reference count. This sums all
+ *		per-CPU counters while live, and is unsafe for synchronization.
+ */
+struct os_pcpu_ref;
+#define OS_PCPU_REF_LIVE        UINT32_MAX
+
+static bool os_pcpu_ref_init(struct os_pcpu_ref *, struct os_refgrp *) OS_WARN_RESULT;
+static os_ref_count_t os_pcpu_ref_kill(struct os_pcpu_ref *) OS_WARN_RESULT;
+static void os_pcpu_ref_destroy(struct os_pcpu_ref *);
+static void os_pcpu_ref_retain(struct os_pcpu_ref *);
+static bool os_pcpu_ref_retain_try(struct os_pcpu_ref *) OS_WARN_RESULT;
+static os_ref_count_t os_pcpu_ref_release(struct os_pcpu_ref *) OS_WARN_RESULT;
+static void os_pcpu_ref_release_live(struct os_pcpu_ref *);
+static os_ref_count_t os_pcpu_ref_get_count(struct os_pcpu_ref *);
+
 
 
 __END_DECLS
@@ -241,6 +241,113 @@ os_ref_get_count_raw(os_ref_atomic_t *rc)
 #define os_ref_release_locked_raw(rc, grp) (os_ref_release_locked_raw)((rc), NULL)
 #endif
 
+/*
+ * Per-CPU sharded refcounts
+ *
+ * opr_pcpu points to one signed delta per CPU: a reference can be taken on
+ * one CPU and dropped on another, so only the sum is meaningful. Deltas are
+ * updated with preemption disabled, after checking opr_state.
+ *
+ * While live, opr_count only holds the initial reference: the references
+ * taken since are in the deltas.  os_pcpu_ref_kill() therefore proceeds as
+ * follows, so that opr_count never reaches zero before the deltas are in:
+ *
+ * 1. add OS_PCPU_REF_BIAS to opr_count,
+ * 2. move opr_state to OS_PCPU_REF_STATE_DYING, which sends every new
+ *    operation to opr_count,
+ * 3. wait until every CPU went through a preemption point, so that no
+ *    per-CPU update is in flight,
+ * 4. move opr_state to OS_PCPU_REF_STATE_DEAD, and atomically add to
+ *    opr_count the sum of the deltas, minus OS_PCPU_REF_BIAS and the
+ *    initial reference; the result is the count kill returns.
+ *
+ * During OS_PCPU_REF_STATE_DYING, opr_count is at least the bias, so
+ * releases cannot reach zero (they return OS_PCPU_REF_LIVE, as while live),
+ * os_pcpu_ref_release_live() cannot panic and os_pcpu_ref_retain_try()
+ * succeeds, even for references taken on a CPU while live and dropped
+ * during that window.  The bias is large enough that the folded deltas
+ * cannot bring opr_count below it.
+ */
+#define OS_PCPU_REF_STATE_LIVE          0u
+#define OS_PCPU_REF_STATE_DYING         1u
+#define OS_PCPU_REF_STATE_DEAD          2u
+
+#define OS_PCPU_REF_BIAS                (1u << 30)
+
+struct os_pcpu_ref {
+	_Atomic uint32_t opr_state;
+	os_ref_atomic_t opr_count;
+	int64_t *opr_pcpu;
+#if OS_REFCNT_DEBUG
+	struct os_refgrp *opr_group;
+#endif
+};
+
+bool os_pcpu_ref_init_external(struct os_pcpu_ref *, struct os_refgrp *);
+os_ref_count_t os_pcpu_ref_kill_external(struct os_pcpu_ref *, struct os_refgrp *);
+void os_pcpu_ref_destroy_external(struct os_pcpu_ref *, struct os_refgrp *);
+void os_pcpu_ref_retain_external(struct os_pcpu_ref *, struct os_refgrp *);
+bool os_pcpu_ref_retain_try_external(struct os_pcpu_ref *, struct os_refgrp *);
+os_ref_count_t os_pcpu_ref_release_external(struct os_pcpu_ref *, struct os_refgrp *);
+os_ref_count_t os_pcpu_ref_get_count_external(struct os_pcpu_ref *);
+
+static inline bool
+os_pcpu_ref_init(struct os_pcpu_ref *ref, struct os_refgrp * __unused grp)
+{
+#if OS_REFCNT_DEBUG
+	ref->opr_group = grp;
+#endif
+	return os_pcpu_ref_init_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline os_ref_count_t OS_WARN_RESULT
+os_pcpu_ref_kill(struct os_pcpu_ref *ref)
+{
+	return os_pcpu_ref_kill_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline void
+os_pcpu_ref_destroy(struct os_pcpu_ref *ref)
+{
+	os_pcpu_ref_destroy_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline void
+os_pcpu_ref_retain(struct os_pcpu_ref *ref)
+{
+	os_pcpu_ref_retain_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline bool OS_WARN_RESULT
+os_pcpu_ref_retain_try(struct os_pcpu_ref *ref)
+{
+	return os_pcpu_ref_retain_try_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline os_ref_count_t OS_WARN_RESULT
+os_pcpu_ref_release(struct os_pcpu_ref *ref)
+{
+	return os_pcpu_ref_release_external(ref, os_ref_if_debug(ref->opr_group, NULL));
+}
+
+static inline void
+os_pcpu_ref_release_live(struct os_pcpu_ref *ref)
+{
+	if (__improbable(os_pcpu_ref_release(ref) == 0)) {
+		os_ref_panic_live(ref);
+	}
+}
+
+static inline os_ref_count_t
+os_pcpu_ref_get_count(struct os_pcpu_ref *ref)
+{
+	return os_pcpu_ref_get_count_external(ref);
+}
+
+#if !OS_REFCNT_DEBUG
+#define os_pcpu_ref_init(ref, grp) (os_pcpu_ref_init)((ref), NULL)
+#endif
+
 
 __END_DECLS
 
@@ -116,6 +116,26 @@ const CS_GenericBlob *
 void *          csblob_entitlements_dictionary_copy(struct cs_blob *csblob);
 void            csblob_entitlements_dictionary_set(struct cs_blob *csblob, void * entitlements);
 
+/*
+ * Validated page cache: each cs_blob remembers which of its code slots
+ * are backed by a resident physical page that was hashed and found to
+ * match, together with that page's number and the blob generation at the
+ * time.  A validation is only ever reused for the same physical page
+ * while it stays resident, never across a page-in: the VM clears the
+ * entry with csblob_page_clear_validated() when the page is evicted,
+ * paged out or freed, and any page read back from storage is hashed
+ * again.  csblob_page_is_validated() therefore only succeeds if the
+ * entry is set, was recorded for phys_page, and carries the current
+ * generation.  Bumping the generation drops every entry at once; the
+ * new generation is returned.
+ */
+int             csblob_page_is_validated(struct cs_blob *blob, off_t offset,
+    ppnum_t phys_page);
+void            csblob_page_set_validated(struct cs_blob *blob, off_t offset,
+    ppnum_t phys_page);
+void            csblob_page_clear_validated(struct cs_blob *blob, off_t offset);
+uint32_t        csblob_validated_pages_invalidate(struct cs_blob *blob);
+
 /*
  * Mostly convenience functions below
  */
@@ -154,6 +174,16 @@ int cs_blob_create_validated(vm_address_t* addr, vm_size_t size,
 
 void cs_blob_free(struct cs_blob *blob);
 
+/*
+ * Checks every special slot of the CodeDirectory of blob against the blobs
+ * of its SuperBlob, and every code slot against the pages of the Mach-O
+ * image at addr, hashing the pages in batches with the multi-buffer
+ * SHA-256 engine.  Returns 0 if all slots match, or EBADEXEC and the index
+ * of the first mismatching slot (negative for special slots) in bad_slot.
+ */
+int cs_blob_verify_slots(struct cs_blob *blob, const void *addr, vm_size_t size,
+    int32_t *bad_slot);
+
 
 
 __END_DECLS
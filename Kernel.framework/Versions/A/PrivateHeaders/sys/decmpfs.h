@@ -209,6 +209,7 @@ void decmpfs_cnode_set_vnode_cached_size(decmpfs_cnode *cp, uint64_t size);
 void decmpfs_cnode_set_vnode_cached_nchildren(decmpfs_cnode *cp, uint64_t nchildren);
 void decmpfs_cnode_set_vnode_cached_total_size(decmpfs_cnode *cp, uint64_t total_sz);
 uint32_t decmpfs_cnode_cmp_type(decmpfs_cnode *cp);
+void decmpfs_cnode_purge_chunk_cache(decmpfs_cnode *cp); /* drops the cached chunk table and inflated chunks */
 
 int decmpfs_file_is_compressed(vnode_t vp, decmpfs_cnode *cp);
 errno_t decmpfs_validate_compressed_file(vnode_t vp, decmpfs_cnode *cp);
@@ -226,6 +227,26 @@ typedef int (*decmpfs_fetch_uncompressed_data_func)(vnode_t vp, vfs_context_t ct
 typedef int (*decmpfs_free_compressed_data_func)(vnode_t vp, vfs_context_t ctx, decmpfs_header *hdr);
 typedef uint64_t (*decmpfs_get_decompression_flags_func)(vnode_t vp, vfs_context_t ctx, decmpfs_header *hdr); // returns flags from the DECMPFS_FLAGS enumeration below
 
+/*
+ * Chunked decompressors (registration version DECMPFS_REGISTRATION_VERSION_V4).
+ *
+ * A chunked decompressor describes the file as a sequence of independently
+ * compressed chunks of chunk_size uncompressed bytes each (the last one may be
+ * shorter).  decmpfs fetches the chunk table once, caches it in the
+ * decmpfs_cnode, and services reads and page-ins by decompressing only the
+ * chunks that are needed, spreading multi-chunk requests across threads and
+ * keeping recently inflated chunks in a per-cnode LRU cache.
+ */
+typedef struct {
+	uint32_t chunk_size;      /* uncompressed size of each chunk */
+	uint32_t nchunks;
+	uint64_t offsets[];       /* nchunks + 1 offsets of the compressed chunks, in decompressor defined units */
+} decmpfs_chunk_table;
+
+typedef int (*decmpfs_fetch_chunk_table_func)(vnode_t vp, vfs_context_t ctx, decmpfs_header *hdr, decmpfs_chunk_table **table);
+typedef void (*decmpfs_free_chunk_table_func)(vnode_t vp, vfs_context_t ctx, decmpfs_header *hdr, decmpfs_chunk_table *table);
+typedef int (*decmpfs_decompress_chunk_func)(vnode_t vp, vfs_context_t ctx, decmpfs_header *hdr, const decmpfs_chunk_table *table, uint32_t chunk, void *buf, uint32_t bufsize, uint32_t *bytes_out); // may be called concurrently for different chunks
+
 enum {
 	DECMPFS_FLAGS_FORCE_FLUSH_ON_DECOMPRESS = 1 << 0,
 };
@@ -233,7 +254,14 @@ enum {
 /* Versions that are supported for binary compatibility */
 #define DECMPFS_REGISTRATION_VERSION_V1 1
 #define DECMPFS_REGISTRATION_VERSION_V3 3
+#define DECMPFS_REGISTRATION_VERSION_V4 4
 
+/*
+ * Decompressors that implement the chunked callbacks opt in by setting
+ * decmpfs_registration to DECMPFS_REGISTRATION_VERSION_V4; the default
+ * stays V3 so that existing decompressors keep registering with kernels
+ * that do not know about V4.
+ */
 #define DECMPFS_REGISTRATION_VERSION (DECMPFS_REGISTRATION_VERSION_V3)
 
 typedef struct {
@@ -243,6 +271,10 @@ typedef struct {
 	decmpfs_fetch_uncompressed_data_func  fetch;
 	decmpfs_free_compressed_data_func     free_data;
 	decmpfs_get_decompression_flags_func  get_flags;
+	/* V4 only: optional, fetch is used when fetch_chunk_table is NULL */
+	decmpfs_fetch_chunk_table_func        fetch_chunk_table;
+	decmpfs_free_chunk_table_func         free_chunk_table;
+	decmpfs_decompress_chunk_func         decompress_chunk;
 } decmpfs_registration;
 
 /* hooks for kexts to call */
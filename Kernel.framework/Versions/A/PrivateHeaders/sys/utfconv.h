@@ -206,6 +206,25 @@ int
 utf8_validatestr(const u_int8_t* utf8p, size_t utf8len);
 
 
+/*
+ * utf8_asciilen - Length of the leading ASCII run of a UTF-8 string
+ *
+ * This function takes an UTF-8 input string, utf8p, of utf8len bytes
+ * and returns the number of leading bytes that are 7-bit ASCII, scanning
+ * 32 bytes at a time.  The string must reside in kernel memory.
+ *
+ * utf8_decodestr, utf8_encodestr, utf8_normalizestr and utf8_validatestr
+ * use it to validate and convert ASCII runs in bulk, and only switch to
+ * the per character decomposition and normalization code at the first
+ * non-ASCII byte.  Pure ASCII input is always already normalized.
+ *
+ * ERRORS
+ *    None
+ */
+size_t
+utf8_asciilen(const u_int8_t* utf8p, size_t utf8len);
+
+
 __END_DECLS
 
 #endif /* __APPLE_API_UNSTABLE */
@@ -28,3 +28,81 @@
 
 #pragma once
 
+
+#include <sys/cdefs.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <mach/boolean.h>
+#include <mach/kern_return.h>
+
+__BEGIN_DECLS
+
+typedef enum {
+	CMODE_WK = 0,
+	CMODE_LZ4 = 1,
+	CMODE_HYB = 2,          /* per-page selection between WK and LZ4 */
+	VM_COMPRESSOR_DEFAULT_CODEC = 3,
+	CMODE_INVALID = 4
+} vm_compressor_mode_t;
+
+#define VM_COMPRESSOR_CODEC_BITS        2
+#define VM_COMPRESSOR_MAX_CODECS        (1 << VM_COMPRESSOR_CODEC_BITS)
+
+/*
+ * Codec identifiers, as recorded in the per-slot codec tag of a compressor
+ * segment.  All values, including CINVALID, fit in VM_COMPRESSOR_CODEC_BITS;
+ * CINVALID is the highest tag value and is never assigned to a codec.
+ */
+typedef enum {
+	CCWK = 0,               /* WKdm */
+	CCLZ4 = 1,              /* LZ4 class byte oriented codec */
+	CINVALID = VM_COMPRESSOR_MAX_CODECS - 1
+} vm_compressor_codec_t;
+
+/*
+ * A page compressor.
+ *
+ * vcc_compress compresses the page at @src into @dst and returns the
+ * compressed size, 0 if the page is a single repeated word (whose value
+ * is stored in the first word of @dst), or -1 if it does not compress to
+ * less than @dst_size bytes.  vcc_decompress returns false on malformed
+ * input.  Both are given vcc_scratch_size bytes of per-CPU scratch.
+ */
+typedef struct vm_compressor_codec_ops {
+	const char             *vcc_name;
+	vm_compressor_codec_t   vcc_codec;
+	uint32_t                vcc_scratch_size;
+	int                   (*vcc_compress)(const uint8_t *src, uint8_t *dst,
+	    int32_t dst_size, void *scratch);
+	bool                  (*vcc_decompress)(const uint8_t *src, uint8_t *dst,
+	    uint32_t csize, void *scratch);
+} vm_compressor_codec_ops_t;
+
+extern kern_return_t vm_compressor_codec_register(const vm_compressor_codec_ops_t *ops);
+extern const vm_compressor_codec_ops_t *vm_compressor_codec_lookup(vm_compressor_codec_t codec);
+
+/*
+ * Cheap probe on a sample of the words of a page, used in CMODE_HYB to
+ * pick the codec: pages dominated by zeroes and word aligned repeats
+ * (pointers, counters) go to WKdm, byte oriented data (text, JSON heaps)
+ * goes to LZ4.
+ */
+extern vm_compressor_codec_t vm_compressor_probe(const uint8_t *page);
+
+/*
+ * Compresses a page with the codec selected by the current mode, falling
+ * back to the other codec when the first choice does not fit, and returns
+ * the codec used in @codec, a vm_compressor_codec_t value, for the caller
+ * to record in the segment.
+ */
+extern int metacompressor(const uint8_t *in, uint8_t *cdst, int32_t outbufsz,
+    uint16_t *codec, void *cscratch, boolean_t *incomp_copy, uint32_t *pop_count_p);
+extern bool metadecompressor(const uint8_t *source, uint8_t *dest, uint32_t csize,
+    uint16_t ccodec, void *compressor_dscratch, uint32_t *pop_count_p);
+
+extern void vm_compressor_algorithm_init(void);
+extern vm_compressor_mode_t vm_compressor_algorithm(void);
+extern uint32_t vm_compressor_get_encode_scratch_size(void);
+extern uint32_t vm_compressor_get_decode_scratch_size(void);
+
+__END_DECLS